@@ -21,7 +21,13 @@ public class BlueprintRetarget : ModuleRules
 			"EditorStyle",
 			"SlateCore",
 			"Slate",
-			"BlueprintGraph"
+			"BlueprintGraph",
+			"Kismet",
+			"Json",
+			"AssetRegistry",
+			"ContentBrowser",
+			"SourceControl",
+			"WorkspaceMenuStructure"
 		});
 	}
 }
@@ -2,6 +2,16 @@
 
 #include "BlueprintRetarget.h"
 #include "ContentBrowserExtensions.h"
+#include "BrokenBlueprintIndex.h"
+#include "SBrokenBlueprintsView.h"
+#include "RetargetSuggestions.h"
+#include "RetargetBlueprintFilter.h"
+
+#include <Framework/Application/SlateApplication.h>
+#include <Framework/Docking/TabManager.h>
+#include <Widgets/Docking/SDockTab.h>
+#include <WorkspaceMenuStructure.h>
+#include <WorkspaceMenuStructureModule.h>
 
 
 #define LOCTEXT_NAMESPACE "FBlueprintRetargetModule"
@@ -13,12 +23,52 @@ static const FName BlueprintRetargetTabName("BlueprintRetarget");
 
 void FBlueprintRetargetModule::StartupModule()
 {
+	if (IsRunningCommandlet())
+	{
+		return;
+	}
+
+	FBrokenBlueprintIndex::Get().Initialize();
 	FBlueprintRetargetContentBrowserExtensions::InstallHooks();
+	FBlueprintRetargetContentBrowserExtensions::OfferResume();
+
+	// Loaded classes changed, suggestions must index them again
+	ModulesChangedHandle = FModuleManager::Get().OnModulesChanged().AddLambda([](FName, EModuleChangeReason) {
+		FRetargetSuggestions::Get().Invalidate();
+	});
+
+	FGlobalTabmanager::Get()->RegisterNomadTabSpawner(BlueprintRetargetTabName, FOnSpawnTab::CreateRaw(this, &FBlueprintRetargetModule::SpawnBrokenBlueprintsTab))
+		.SetDisplayName(LOCTEXT("BrokenBlueprintsTabTitle", "Broken Blueprints"))
+		.SetTooltipText(LOCTEXT("BrokenBlueprintsTabTooltip", "Lists all blueprints with a missing parent class"))
+		.SetGroup(WorkspaceMenu::GetMenuStructure().GetDeveloperToolsMiscCategory());
 }
 
 void FBlueprintRetargetModule::ShutdownModule()
 {
+	// Filters are used by commandlets too
+	FRetargetBlueprintFilter::ReleaseSharedCache();
+
+	if (IsRunningCommandlet())
+	{
+		return;
+	}
+
+	if (FSlateApplication::IsInitialized())
+	{
+		FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(BlueprintRetargetTabName);
+	}
+	FModuleManager::Get().OnModulesChanged().Remove(ModulesChangedHandle);
 	FBlueprintRetargetContentBrowserExtensions::RemoveHooks();
+	FBrokenBlueprintIndex::Get().Shutdown();
+}
+
+TSharedRef<SDockTab> FBlueprintRetargetModule::SpawnBrokenBlueprintsTab(const FSpawnTabArgs& Args)
+{
+	return SNew(SDockTab)
+		.TabRole(ETabRole::NomadTab)
+		[
+			SNew(SBrokenBlueprintsView)
+		];
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,308 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "BlueprintRetargetBenchmarkCommandlet.h"
+#include "BlueprintRetarget.h"
+#include "BlueprintRetargeter.h"
+#include "RetargetCompatibility.h"
+#include "BrokenBlueprintIndex.h"
+#include "RetargetBlueprintFilter.h"
+#include "RetargetStats.h"
+
+#include <AssetData.h>
+#include <Animation/AnimBlueprint.h>
+#include <Animation/AnimBlueprintGeneratedClass.h>
+#include <Animation/AnimInstance.h>
+#include <Components/ActorComponent.h>
+#include <Engine/Blueprint.h>
+#include <Engine/BlueprintGeneratedClass.h>
+#include <GameFramework/Actor.h>
+#include <EdGraph/EdGraph.h>
+#include <EdGraphSchema_K2.h>
+#include <K2Node_CallFunction.h>
+#include <K2Node_CustomEvent.h>
+#include <Kismet/KismetSystemLibrary.h>
+#include <Kismet2/BlueprintEditorUtils.h>
+#include <Kismet2/KismetEditorUtilities.h>
+#include <HAL/PlatformMemory.h>
+#include <HAL/PlatformTime.h>
+#include <Misc/EngineVersion.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <Dom/JsonObject.h>
+#include <Serialization/JsonWriter.h>
+#include <Serialization/JsonSerializer.h>
+#include <UObject/Package.h>
+#include <UObject/UObjectHash.h>
+#include <UObject/UObjectIterator.h>
+
+
+struct FBenchmarkKind
+{
+	const TCHAR* Name;
+	UClass* NewParent;
+	UClass* BlueprintClass;
+	UClass* GeneratedClass;
+
+	/** Parent that gets broken */
+	UBlueprint* OldParent = nullptr;
+	TArray<UBlueprint*> Blueprints;
+};
+
+
+UBlueprintRetargetBenchmarkCommandlet::UBlueprintRetargetBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBlueprintRetargetBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString CountsParam = TEXT("10,100,1000");
+	FParse::Value(*Params, TEXT("counts="), CountsParam, false);
+
+	int32 GraphNodes = 10;
+	FParse::Value(*Params, TEXT("nodes="), GraphNodes);
+
+	FString OutputFile = FPaths::ProjectSavedDir() / TEXT("BlueprintRetarget") / TEXT("Benchmark.json");
+	FParse::Value(*Params, TEXT("output="), OutputFile);
+
+	TArray<FString> Counts;
+	CountsParam.ParseIntoArray(Counts, TEXT(","));
+
+	TArray<TSharedPtr<FJsonValue>> Runs;
+	for (const FString& Count : Counts)
+	{
+		const int32 NumBlueprints = FCString::Atoi(*Count);
+		if (NumBlueprints <= 0)
+		{
+			UE_LOG(LogBlueprintReparent, Warning, TEXT("Ignored invalid blueprint count '%s'"), *Count);
+			continue;
+		}
+		Runs.Add(MakeShared<FJsonValueObject>(RunBenchmark(NumBlueprints, GraphNodes)));
+	}
+
+	TSharedRef<FJsonObject> Results = MakeShared<FJsonObject>();
+	Results->SetStringField(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+	Results->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+	Results->SetNumberField(TEXT("GraphNodes"), GraphNodes);
+	Results->SetArrayField(TEXT("Runs"), Runs);
+
+	FString ResultsText;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ResultsText);
+	FJsonSerializer::Serialize(Results, Writer);
+	if (!FFileHelper::SaveStringToFile(ResultsText, *OutputFile))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't write benchmark results to '%s'"), *OutputFile);
+		return 1;
+	}
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Benchmark results written to '%s'"), *OutputFile);
+	return 0;
+}
+
+TSharedRef<FJsonObject> UBlueprintRetargetBenchmarkCommandlet::RunBenchmark(int32 NumBlueprints, int32 GraphNodes) const
+{
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Benchmarking %i blueprints with %i graph nodes..."), NumBlueprints, GraphNodes);
+
+	TSharedRef<FJsonObject> Seconds = MakeShared<FJsonObject>();
+	double TotalSeconds = 0.0;
+	uint64 PeakUsedMemory = 0;
+	auto Measure = [&](const TCHAR* Name, TFunctionRef<void()> Step) {
+		const double StartTime = FPlatformTime::Seconds();
+		Step();
+		const double StepSeconds = FPlatformTime::Seconds() - StartTime;
+
+		Seconds->SetNumberField(Name, StepSeconds);
+		TotalSeconds += StepSeconds;
+		PeakUsedMemory = FMath::Max<uint64>(PeakUsedMemory, FPlatformMemory::GetStats().UsedPhysical);
+	};
+
+	FBenchmarkKind Kinds[] = {
+		{ TEXT("Actor"), AActor::StaticClass(), UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass() },
+		{ TEXT("Component"), UActorComponent::StaticClass(), UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass() },
+		{ TEXT("Object"), UObject::StaticClass(), UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass() },
+		{ TEXT("AnimBlueprint"), UAnimInstance::StaticClass(), UAnimBlueprint::StaticClass(), UAnimBlueprintGeneratedClass::StaticClass() }
+	};
+	const int32 NumKinds = UE_ARRAY_COUNT(Kinds);
+
+	TArray<UBlueprint*> Blueprints;
+	TArray<FAssetData> Assets;
+	Measure(TEXT("Generate"), [&]() {
+		for (FBenchmarkKind& Kind : Kinds)
+		{
+			Kind.OldParent = CreateBlueprint(Kind.NewParent, Kind.BlueprintClass, Kind.GeneratedClass, FString::Printf(TEXT("BP_OldParent_%s"), Kind.Name), 0);
+		}
+
+		for (int32 I = 0; I < NumBlueprints; ++I)
+		{
+			FBenchmarkKind& Kind = Kinds[I % NumKinds];
+			UBlueprint* Blueprint = CreateBlueprint(Kind.OldParent->GeneratedClass, Kind.BlueprintClass, Kind.GeneratedClass, FString::Printf(TEXT("BP_%s_%i"), Kind.Name, I), GraphNodes);
+			Kind.Blueprints.Add(Blueprint);
+			Blueprints.Add(Blueprint);
+		}
+
+		for (UBlueprint* Blueprint : Blueprints)
+		{
+			BreakParent(Blueprint);
+			Assets.Add(FAssetData(Blueprint));
+		}
+	});
+	// Generation is not part of the retarget
+	TotalSeconds -= Seconds->GetNumberField(TEXT("Generate"));
+
+	FRetargetProfiler::Get().Reset();
+
+	int32 NumBroken = 0;
+	Measure(TEXT("MenuCheck"), [&]() {
+		for (const FAssetData& AssetData : Assets)
+		{
+			NumBroken += FBrokenBlueprintIndex::Get().IsBroken(AssetData);
+		}
+	});
+
+	TSharedPtr<FRetargetBlueprintFilter> Filter;
+	Measure(TEXT("PrepareFilter"), [&]() {
+		Filter = FRetargetBlueprintFilter::Create(Assets);
+	});
+
+	int32 NumEligible = 0;
+	Measure(TEXT("FilterEvaluation"), [&]() {
+		for (TObjectIterator<UClass> It; It; ++It)
+		{
+			NumEligible += Filter->IsClassEligible(*It);
+		}
+	});
+
+	int32 NumIncompatible = 0;
+	Measure(TEXT("Analyze"), [&]() {
+		TArray<TPair<UBlueprint*, UClass*>> Reparents;
+		for (FBenchmarkKind& Kind : Kinds)
+		{
+			for (UBlueprint* Blueprint : Kind.Blueprints)
+			{
+				Reparents.Emplace(Blueprint, Kind.NewParent);
+			}
+		}
+
+		for (const FRetargetCompatibilityReport& Report : FRetargetCompatibility::Analyze(Reparents))
+		{
+			NumIncompatible += !Report.IsCompatible();
+		}
+	});
+
+	FBlueprintRetargeter Retargeter{ false };
+	TArray<UBlueprint*> Reparented;
+	Measure(TEXT("Reparent"), [&]() {
+		for (FBenchmarkKind& Kind : Kinds)
+		{
+			for (UBlueprint* Blueprint : Kind.Blueprints)
+			{
+				if (Retargeter.BeginReparent(Blueprint, Kind.NewParent))
+				{
+					Reparented.Add(Blueprint);
+				}
+			}
+		}
+	});
+
+	Measure(TEXT("Compile"), [&]() {
+		Retargeter.CompileBlueprints(Reparented);
+	});
+
+	int32 NumCompileErrors = 0;
+	Measure(TEXT("EndReparent"), [&]() {
+		for (UBlueprint* Blueprint : Reparented)
+		{
+			Retargeter.EndReparent(Blueprint);
+			NumCompileErrors += Blueprint->Status == BS_Error;
+		}
+	});
+	Seconds->SetNumberField(TEXT("Total"), TotalSeconds);
+
+	// Time spent inside the retargeter, per phase
+	TSharedRef<FJsonObject> Phases = MakeShared<FJsonObject>();
+	const FRetargetPhaseRecord& PhaseTotals = FRetargetProfiler::Get().GetTotal();
+	for (int32 Phase = 0; Phase < (int32)ERetargetPhase::Num; ++Phase)
+	{
+		Phases->SetNumberField(FRetargetProfiler::GetPhaseName((ERetargetPhase)Phase), PhaseTotals.Seconds[Phase]);
+	}
+
+	TSharedRef<FJsonObject> Run = MakeShared<FJsonObject>();
+	Run->SetNumberField(TEXT("Blueprints"), NumBlueprints);
+	Run->SetNumberField(TEXT("Broken"), NumBroken);
+	Run->SetNumberField(TEXT("EligibleClasses"), NumEligible);
+	Run->SetNumberField(TEXT("Incompatible"), NumIncompatible);
+	Run->SetNumberField(TEXT("Reparented"), Reparented.Num());
+	Run->SetNumberField(TEXT("CompileErrors"), NumCompileErrors);
+	Run->SetNumberField(TEXT("PeakUsedMemoryMB"), double(PeakUsedMemory) / (1024.0 * 1024.0));
+	Run->SetObjectField(TEXT("Seconds"), Seconds);
+	Run->SetObjectField(TEXT("Phases"), Phases);
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Retargeted %i of %i blueprints in %.3fs"), Reparented.Num(), NumBlueprints, TotalSeconds);
+
+	for (FBenchmarkKind& Kind : Kinds)
+	{
+		Blueprints.Add(Kind.OldParent);
+	}
+	DestroyBlueprints(Blueprints);
+	return Run;
+}
+
+UBlueprint* UBlueprintRetargetBenchmarkCommandlet::CreateBlueprint(UClass* ParentClass, UClass* BlueprintClass, UClass* GeneratedClass, const FString& Name, int32 GraphNodes) const
+{
+	UPackage* Package = CreatePackage(nullptr, *(TEXT("/Temp/BlueprintRetargetBenchmark/") + Name));
+	Package->SetFlags(RF_Transient);
+
+	UBlueprint* Blueprint = FKismetEditorUtilities::CreateBlueprint(ParentClass, Package, FName(*Name), BPTYPE_Normal, BlueprintClass, GeneratedClass);
+	AddGraphNodes(Blueprint, GraphNodes);
+	return Blueprint;
+}
+
+void UBlueprintRetargetBenchmarkCommandlet::AddGraphNodes(UBlueprint* Blueprint, int32 GraphNodes) const
+{
+	UEdGraph* Graph = FBlueprintEditorUtils::FindEventGraph(Blueprint);
+	if (!Graph || GraphNodes <= 0)
+	{
+		return;
+	}
+
+	FGraphNodeCreator<UK2Node_CustomEvent> EventCreator(*Graph);
+	UK2Node_CustomEvent* Event = EventCreator.CreateNode();
+	Event->CustomFunctionName = TEXT("BenchmarkEvent");
+	EventCreator.Finalize();
+
+	UFunction* PrintString = UKismetSystemLibrary::StaticClass()->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(UKismetSystemLibrary, PrintString));
+	UEdGraphPin* LastThen = Event->FindPinChecked(UEdGraphSchema_K2::PN_Then);
+	for (int32 I = 0; I < GraphNodes; ++I)
+	{
+		FGraphNodeCreator<UK2Node_CallFunction> CallCreator(*Graph);
+		UK2Node_CallFunction* Call = CallCreator.CreateNode();
+		Call->SetFromFunction(PrintString);
+		Call->NodePosX = (I + 1) * 300;
+		CallCreator.Finalize();
+
+		LastThen->MakeLinkTo(Call->GetExecPin());
+		LastThen = Call->GetThenPin();
+	}
+}
+
+void UBlueprintRetargetBenchmarkCommandlet::BreakParent(UBlueprint* Blueprint) const
+{
+	// A parent that fails to load leaves no parent and no skeleton class
+	Blueprint->ParentClass = nullptr;
+	Blueprint->SkeletonGeneratedClass = nullptr;
+	Blueprint->Status = BS_Error;
+}
+
+void UBlueprintRetargetBenchmarkCommandlet::DestroyBlueprints(const TArray<UBlueprint*>& Blueprints) const
+{
+	for (UBlueprint* Blueprint : Blueprints)
+	{
+		ForEachObjectWithOuter(Blueprint->GetOutermost(), [](UObject* Object) {
+			Object->ClearFlags(RF_Standalone | RF_Public);
+		}, true);
+	}
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
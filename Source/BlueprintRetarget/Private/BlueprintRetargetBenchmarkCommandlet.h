@@ -0,0 +1,46 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Commandlets/Commandlet.h>
+
+#include "BlueprintRetargetBenchmarkCommandlet.generated.h"
+
+class FJsonObject;
+class UBlueprint;
+
+
+/**
+ * Measures the retarget pipeline on synthetic broken blueprints, so that performance changes can be compared between runs.
+ *
+ * Usage: UE4Editor-Cmd.exe Project.uproject -run=BlueprintRetargetBenchmark [-counts=10,100,1000] [-nodes=10] [-output=Benchmark.json]
+ *
+ * For each count, that many Actor, Component, Object and Anim blueprints are generated in transient packages with
+ * a graph of the given amount of nodes, their parent gets broken and they are retargeted like from the editor.
+ */
+UCLASS()
+class UBlueprintRetargetBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UBlueprintRetargetBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+
+	TSharedRef<FJsonObject> RunBenchmark(int32 NumBlueprints, int32 GraphNodes) const;
+
+	UBlueprint* CreateBlueprint(UClass* ParentClass, UClass* BlueprintClass, UClass* GeneratedClass, const FString& Name, int32 GraphNodes) const;
+
+	/** Adds a custom event followed by a chain of function calls */
+	void AddGraphNodes(UBlueprint* Blueprint, int32 GraphNodes) const;
+
+	/** Leaves blueprints like they are after loading them without their parent class */
+	void BreakParent(UBlueprint* Blueprint) const;
+
+	void DestroyBlueprints(const TArray<UBlueprint*>& Blueprints) const;
+};
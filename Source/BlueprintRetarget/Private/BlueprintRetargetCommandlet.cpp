@@ -0,0 +1,1240 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "BlueprintRetargetCommandlet.h"
+#include "BlueprintRetarget.h"
+#include "BlueprintRetargeter.h"
+#include "RetargetUtils.h"
+#include "RetargetBlueprintFilter.h"
+#include "RetargetSuggestions.h"
+#include "RetargetRedirects.h"
+#include "RetargetStats.h"
+#include "RetargetBackup.h"
+#include "RetargetPackageScanner.h"
+#include "RetargetHierarchy.h"
+#include "RetargetPackagePatcher.h"
+#include "RetargetReferencers.h"
+#include "RetargetPackageSaver.h"
+
+#include <AssetRegistryModule.h>
+#include <Engine/Blueprint.h>
+#include <Misc/FileHelper.h>
+#include <Misc/PackageName.h>
+#include <Misc/Paths.h>
+#include <Misc/SecureHash.h>
+#include <Dom/JsonObject.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonWriter.h>
+#include <Serialization/JsonSerializer.h>
+#include <UObject/Package.h>
+#include <Misc/Optional.h>
+#include <PackageTools.h>
+#include <Algo/Find.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformProcess.h>
+
+
+struct FRetargetItem
+{
+	FAssetData AssetData;
+	FString OldParent;
+	FString NewParent;
+
+	/** Set only if the blueprint was reparented */
+	UBlueprint* Blueprint = nullptr;
+	FString Result;
+};
+
+static bool HasSucceeded(const FRetargetItem& Item)
+{
+	return Item.Result == TEXT("Saved") || Item.Result == TEXT("Reparented") ||
+		Item.Result == TEXT("Redirected") || Item.Result == TEXT("Patched");
+}
+
+/** Blueprints whose missing parent was only renamed or moved */
+struct FMovedParent
+{
+	FString OldPath;
+	UClass* NewClass = nullptr;
+	TArray<FAssetData> Blueprints;
+};
+
+static constexpr float WorkerPollSeconds = 0.5f;
+/** Time a killed worker is given to exit */
+static constexpr double WorkerKillSeconds = 30.0;
+
+
+UBlueprintRetargetCommandlet::UBlueprintRetargetCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+	Retargeter.Journal = &Journal;
+}
+
+int32 UBlueprintRetargetCommandlet::Main(const FString& Params)
+{
+	FString RestoreDirectory;
+	if (FParse::Value(*Params, TEXT("restore="), RestoreDirectory) || FParse::Param(*Params, TEXT("restore")))
+	{
+		return RestoreBackup(RestoreDirectory);
+	}
+
+	FString ReportFile = FPaths::ProjectSavedDir() / TEXT("BlueprintRetarget") / TEXT("Report.json");
+	FParse::Value(*Params, TEXT("report="), ReportFile);
+
+	FString RootPath = TEXT("/Game");
+	FParse::Value(*Params, TEXT("path="), RootPath);
+
+	if (FParse::Param(*Params, TEXT("scan")))
+	{
+		return ScanPackages(RootPath, ReportFile);
+	}
+
+	FString MapFile;
+	const bool bHasMap = FParse::Value(*Params, TEXT("map="), MapFile);
+	const bool bSuggest = FParse::Param(*Params, TEXT("suggest"));
+	if (!bHasMap && !bSuggest)
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("No mapping file provided. Usage: -run=BlueprintRetarget -map=Retarget.json"));
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("minscore="), MinSuggestionScore);
+
+	bSave = !FParse::Param(*Params, TEXT("nosave"));
+	Retargeter.bRejectIncompatible = FParse::Param(*Params, TEXT("strict"));
+	const bool bBackup = FParse::Param(*Params, TEXT("backup"));
+
+	int32 ChunkMemoryMB = 4096;
+	FParse::Value(*Params, TEXT("chunkmb="), ChunkMemoryMB);
+
+	FString StatsFile;
+	FParse::Value(*Params, TEXT("csv="), StatsFile);
+	const bool bRedirect = !FParse::Param(*Params, TEXT("noredirect"));
+	const bool bPatch = FParse::Param(*Params, TEXT("patch"));
+	int32 NumVerify = 10;
+	FParse::Value(*Params, TEXT("verify="), NumVerify);
+	const bool bReferencers = FParse::Param(*Params, TEXT("referencers"));
+
+	int32 NumWorkers = 1;
+	FParse::Value(*Params, TEXT("workers="), NumWorkers);
+	int32 Retries = 1;
+	FParse::Value(*Params, TEXT("retries="), Retries);
+	int32 WorkerTimeoutMinutes = 240;
+	FParse::Value(*Params, TEXT("workertimeout="), WorkerTimeoutMinutes);
+
+	FString ShardFile;
+	FParse::Value(*Params, TEXT("shard="), ShardFile);
+	FString BackupDirectory;
+	FParse::Value(*Params, TEXT("backupdir="), BackupDirectory);
+	FString JournalFile = FRetargetJournal::GetDefaultFilename();
+	FParse::Value(*Params, TEXT("journal="), JournalFile);
+
+	FString MappingsHash;
+	if (bHasMap && !LoadMappings(MapFile, Mappings, MappingsHash))
+	{
+		return 1;
+	}
+
+	FRetargetProfiler::Get().Reset();
+
+	TArray<FAssetData> Blueprints;
+	FindBrokenBlueprints(RootPath, Mappings, bSuggest, Blueprints);
+
+	// Workers only retarget the blueprints of their shard
+	TArray<FName> ShardSuspects;
+	if (!ShardFile.IsEmpty())
+	{
+		TSet<FName> Shard;
+		if (!LoadShard(ShardFile, Shard, ShardSuspects))
+		{
+			return 1;
+		}
+		Blueprints.RemoveAll([&Shard](const FAssetData& AssetData) {
+			return !Shard.Contains(AssetData.ObjectPath);
+		});
+	}
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Found %i broken blueprints to retarget"), Blueprints.Num());
+
+	// An interrupted run is continued. Blueprints it finished are skipped and the one it crashed on is quarantined
+	FRetargetJournalContents Resumed;
+	TArray<FName> Suspects;
+	const bool bRestart = FParse::Param(*Params, TEXT("restart"));
+
+	// Parents chosen by the interrupted run come from its mapping file. They would silently override a different one
+	FRetargetJournalContents Interrupted;
+	if (!bRestart && FRetargetJournal::Read(JournalFile, Interrupted) && !Interrupted.bFinished && Interrupted.MappingsHash != MappingsHash)
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("The interrupted retarget in '%s' used a different mapping file. Run with the same -map to resume it, or with -restart to discard it"), *JournalFile);
+		return 1;
+	}
+
+	if (bRestart || !Journal.Resume(JournalFile, Resumed, Suspects))
+	{
+		Journal.Open(JournalFile);
+		Journal.SetMappingsHash(MappingsHash);
+	}
+	Suspects.Append(ShardSuspects);
+	auto FindDone = [&Resumed](const FAssetData& AssetData) -> const FRetargetJournalEntry* {
+		const FRetargetJournalEntry* Entry = Resumed.Entries.Find(AssetData.PackageName);
+		return Entry && Entry->IsDone() ? Entry : nullptr;
+	};
+
+	// Every file that may be written is checked out in a single request, instead of one by one while saving
+	TMap<FName, FString> NotWritable;
+	if (bSave)
+	{
+		TArray<FName> PackageNames;
+		for (const FAssetData& AssetData : Blueprints)
+		{
+			if (!FindDone(AssetData))
+			{
+				PackageNames.Add(AssetData.PackageName);
+			}
+		}
+		NotWritable = FRetargetPackageSaver::CheckOut(PackageNames);
+	}
+
+	TArray<FAssetData> Writable = Blueprints;
+	Writable.RemoveAll([&NotWritable, &FindDone](const FAssetData& AssetData) {
+		return NotWritable.Contains(AssetData.PackageName) || FindDone(AssetData);
+	});
+
+	// Parents that were only renamed or moved are patched into the package files, or redirected. Their blueprints don't need to be loaded
+	TMap<FName, FString> Patched;
+	if (bPatch && bSave)
+	{
+		PatchMovedParents(FindMovedParents(Writable, Mappings, bSuggest), NumVerify, Patched);
+	}
+
+	TMap<FName, FString> Redirected;
+	if (bRedirect)
+	{
+		TArray<FAssetData> Unpatched = Writable;
+		Unpatched.RemoveAll([&Patched](const FAssetData& AssetData) {
+			return Patched.Contains(AssetData.ObjectPath);
+		});
+		RedirectMovedParents(FindMovedParents(Unpatched, Mappings, bSuggest), Redirected);
+	}
+
+	// Children of patched or redirected blueprints load fine through their parent. They don't need to be touched either
+	const FRetargetHierarchy Hierarchy{ Blueprints };
+	for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
+	{
+		if (Node.Parent == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FName BatchRootPath = Hierarchy.Nodes[Hierarchy.Batches[Node.Batch][0]].AssetData.ObjectPath;
+		if (Patched.Contains(BatchRootPath))
+		{
+			Patched.Add(Node.AssetData.ObjectPath, FRetargetUtils::GetParentClassPath(Node.AssetData));
+		}
+		else if (Redirected.Contains(BatchRootPath))
+		{
+			Redirected.Add(Node.AssetData.ObjectPath, FRetargetUtils::GetParentClassPath(Node.AssetData));
+		}
+	}
+
+	TArray<FRetargetItem> Items;
+	TArray<int32> PendingItems;
+	for (const FAssetData& AssetData : Blueprints)
+	{
+		FRetargetItem& Item = Items.AddDefaulted_GetRef();
+		Item.AssetData = AssetData;
+		Item.OldParent = FRetargetUtils::GetParentClassPath(AssetData);
+
+		if (const FRetargetJournalEntry* Done = FindDone(AssetData))
+		{
+			Item.NewParent = Done->NewParent;
+			Item.Result = Done->State == ERetargetJournalState::Saved ? FString(TEXT("Saved")) :
+				Done->State == ERetargetJournalState::Quarantined ? FString(TEXT("Quarantined")) : Done->Reason;
+			continue;
+		}
+		if (NotWritable.Contains(AssetData.PackageName))
+		{
+			Item.Result = TEXT("CheckOutFailed");
+			continue;
+		}
+
+		if (const FString* PatchedParent = Patched.Find(AssetData.ObjectPath))
+		{
+			Item.NewParent = *PatchedParent;
+			Item.Result = TEXT("Patched");
+			continue;
+		}
+		if (const FString* RedirectedParent = Redirected.Find(AssetData.ObjectPath))
+		{
+			Item.NewParent = *RedirectedParent;
+			Item.Result = TEXT("Redirected");
+			continue;
+		}
+		// Parents chosen by an interrupted run are kept, even if they were suggested. Children keep their parent blueprint
+		const FRetargetJournalEntry* Entry = Resumed.Entries.Find(AssetData.PackageName);
+		if (!FRetargetUtils::HasMissingParent(AssetData))
+		{
+			Item.NewParent = Item.OldParent;
+		}
+		else if (Entry && !Entry->NewParent.IsEmpty())
+		{
+			Item.NewParent = Entry->NewParent;
+		}
+		else
+		{
+			Item.NewParent = Mappings.FindRef(Item.OldParent);
+		}
+		Journal.Record(AssetData.PackageName, ERetargetJournalState::Pending, Item.NewParent);
+
+		PendingItems.Add(Items.Num() - 1);
+	}
+
+	TOptional<FRetargetBackup> Backup;
+	if (bSave && bBackup)
+	{
+		Backup.Emplace(BackupDirectory);
+	}
+
+	if (NumWorkers > 1)
+	{
+		RunWorkers(Params, Items, PendingItems, Suspects, NumWorkers, Retries, WorkerTimeoutMinutes, Backup.GetPtrOrNull());
+	}
+	else
+	{
+		TMap<FName, FRetargetItem*> PendingByPath;
+		TArray<FAssetData> Pending;
+		for (int32 ItemIndex : PendingItems)
+		{
+			PendingByPath.Add(Items[ItemIndex].AssetData.ObjectPath, &Items[ItemIndex]);
+			Pending.Add(Items[ItemIndex].AssetData);
+		}
+
+		// Only a chunk of blueprints is loaded at a time. They get saved and unloaded before the next one.
+		// Parents always go before their children. Blueprints compiled together when a previous run crashed go alone,
+		// so that a new crash points to one of them
+		const TArray<TArray<FAssetData>> Chunks = FRetargetHierarchy{ Pending }.SplitByMemory(int64(ChunkMemoryMB) * 1024 * 1024, Suspects);
+		for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex)
+		{
+			if (Chunks.Num() > 1)
+			{
+				UE_LOG(LogBlueprintReparent, Display, TEXT("Retargeting chunk %i of %i (%i blueprints)"), ChunkIndex + 1, Chunks.Num(), Chunks[ChunkIndex].Num());
+			}
+
+			TArray<FRetargetItem*> ChunkItems;
+			for (const FAssetData& AssetData : Chunks[ChunkIndex])
+			{
+				ChunkItems.Add(PendingByPath.FindChecked(AssetData.ObjectPath));
+			}
+
+			if (!RetargetChunk(ChunkItems, Backup.GetPtrOrNull(), Chunks.Num() > 1))
+			{
+				// Nothing crashed. Blueprints left pending are retargeted again by the next run, none is quarantined
+				Journal.SetActive({});
+				return 1;
+			}
+		}
+	}
+
+	TArray<TSharedPtr<FJsonValue>> ReportEntries;
+	int32 NumFailed = 0;
+	for (const FRetargetItem& Item : Items)
+	{
+		if (!HasSucceeded(Item))
+		{
+			++NumFailed;
+			UE_LOG(LogBlueprintReparent, Error, TEXT("Failed to retarget %s: %s"), *Item.AssetData.ObjectPath.ToString(), *Item.Result);
+		}
+
+		TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+		Entry->SetStringField(TEXT("Blueprint"), Item.AssetData.ObjectPath.ToString());
+		Entry->SetStringField(TEXT("OldParent"), Item.OldParent);
+		Entry->SetStringField(TEXT("NewParent"), Item.NewParent);
+		Entry->SetStringField(TEXT("Result"), Item.Result);
+		ReportEntries.Add(MakeShared<FJsonValueObject>(Entry));
+	}
+
+	// Write report
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("Total"), Blueprints.Num());
+	Report->SetNumberField(TEXT("Succeeded"), Blueprints.Num() - NumFailed);
+	Report->SetNumberField(TEXT("Failed"), NumFailed);
+	Report->SetArrayField(TEXT("Blueprints"), ReportEntries);
+
+	// Only blueprints depending on what changed are recompiled, instead of the whole project
+	int32 NumReferencersFailed = 0;
+	if (bReferencers)
+	{
+		NumReferencersFailed = RecompileReferencers(Items, Backup.GetPtrOrNull(), *Report);
+	}
+
+	FString ReportText;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ReportText);
+	FJsonSerializer::Serialize(Report, Writer);
+	if (!FFileHelper::SaveStringToFile(ReportText, *ReportFile))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't write report to '%s'"), *ReportFile);
+	}
+
+	FRetargetProfiler::Get().PrintSummary();
+	if (!StatsFile.IsEmpty())
+	{
+		FRetargetProfiler::Get().WriteCsv(StatsFile);
+	}
+
+	Journal.Finish();
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Retargeted %i of %i blueprints. Report: %s"), Blueprints.Num() - NumFailed, Blueprints.Num(), *ReportFile);
+	return (NumFailed + NumReferencersFailed) > 0 ? 1 : 0;
+}
+
+int32 UBlueprintRetargetCommandlet::RecompileReferencers(const TArray<FRetargetItem>& Items, FRetargetBackup* Backup, FJsonObject& Report) const
+{
+	TArray<FName> RetargetedPackages;
+	for (const FRetargetItem& Item : Items)
+	{
+		if (HasSucceeded(Item))
+		{
+			RetargetedPackages.Add(Item.AssetData.PackageName);
+		}
+	}
+
+	const FRetargetReferencers Referencers{ RetargetedPackages };
+	const FRetargetReferencersResult Result = Referencers.Recompile();
+
+	TArray<UBlueprint*> ToSave;
+	for (UBlueprint* Blueprint : Result.Recompiled)
+	{
+		if (!Result.Failed.Contains(Blueprint))
+		{
+			ToSave.Add(Blueprint);
+		}
+	}
+
+	TMap<FName, FString> NotWritable;
+	if (bSave && ToSave.Num() > 0)
+	{
+		TArray<FName> PackageNames;
+		for (UBlueprint* Blueprint : ToSave)
+		{
+			PackageNames.Add(Blueprint->GetOutermost()->GetFName());
+		}
+		NotWritable = FRetargetPackageSaver::CheckOut(PackageNames);
+		ToSave.RemoveAll([&NotWritable](UBlueprint* Blueprint) {
+			return NotWritable.Contains(Blueprint->GetOutermost()->GetFName());
+		});
+	}
+
+	// Files are backed up before saving over them, like retargeted blueprints
+	bool bCanSave = bSave && ToSave.Num() > 0;
+	if (bCanSave && Backup)
+	{
+		for (UBlueprint* Blueprint : ToSave)
+		{
+			bCanSave &= Backup->Add(Blueprint->GetOutermost()->GetFName());
+		}
+		bCanSave = bCanSave && Backup->Save();
+		if (!bCanSave)
+		{
+			UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't backup referencers. They were recompiled but not saved"));
+		}
+	}
+
+	FRetargetSaveResult SaveResult;
+	if (bCanSave)
+	{
+		TArray<UPackage*> Packages;
+		for (UBlueprint* Blueprint : ToSave)
+		{
+			Packages.Add(Blueprint->GetOutermost());
+		}
+		SaveResult = FRetargetPackageSaver::Save(Packages);
+	}
+
+	int32 NumFailed = 0;
+	TArray<TSharedPtr<FJsonValue>> Entries;
+	for (UBlueprint* Blueprint : Result.Recompiled)
+	{
+		FString EntryResult = TEXT("Recompiled");
+		if (Result.Failed.Contains(Blueprint))
+		{
+			EntryResult = TEXT("CompileFailed");
+		}
+		else if (NotWritable.Contains(Blueprint->GetOutermost()->GetFName()))
+		{
+			EntryResult = TEXT("CheckOutFailed");
+		}
+		else if (bCanSave)
+		{
+			EntryResult = SaveResult.Failed.Contains(Blueprint->GetOutermost()) ? TEXT("SaveFailed") : TEXT("Saved");
+		}
+		NumFailed += EntryResult.EndsWith(TEXT("Failed"));
+
+		TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+		Entry->SetStringField(TEXT("Blueprint"), Blueprint->GetPathName());
+		Entry->SetStringField(TEXT("Result"), EntryResult);
+		Entries.Add(MakeShared<FJsonValueObject>(Entry));
+	}
+
+	// Levels and other assets can't be recompiled, only resaved by the user
+	TArray<TSharedPtr<FJsonValue>> OtherEntries;
+	for (const FName& Package : Referencers.GetOtherReferencers())
+	{
+		OtherEntries.Add(MakeShared<FJsonValueString>(Package.ToString()));
+	}
+
+	Report.SetNumberField(TEXT("ReferencersSkipped"), Result.NumSkipped);
+	Report.SetNumberField(TEXT("ReferencersFailed"), NumFailed);
+	Report.SetArrayField(TEXT("Referencers"), Entries);
+	Report.SetArrayField(TEXT("OtherReferencers"), OtherEntries);
+	return NumFailed;
+}
+
+bool UBlueprintRetargetCommandlet::RetargetChunk(const TArray<FRetargetItem*>& Items, FRetargetBackup* Backup, bool bUnload)
+{
+	// Children keep their parent blueprint and get compiled after it, like in the editor
+	TArray<FAssetData> Assets;
+	TMap<FName, FRetargetItem*> ItemsByPath;
+	for (FRetargetItem* Item : Items)
+	{
+		Assets.Add(Item->AssetData);
+		ItemsByPath.Add(Item->AssetData.ObjectPath, Item);
+	}
+	FRetargetHierarchy Hierarchy{ Assets };
+
+	for (int32 Index : Hierarchy.Order)
+	{
+		FRetargetHierarchy::FNode& Node = Hierarchy.Nodes[Index];
+		Node.Blueprint = LoadRetarget(*ItemsByPath.FindChecked(Node.AssetData.ObjectPath), Node.NewParent);
+	}
+
+	// Roots are analyzed before modifying any blueprint. Levels of the hierarchy are compiled together, parents first
+	FRetargetHierarchyTask Task{ Retargeter, Hierarchy };
+	while (Task.Step()) {}
+
+	const TSet<UBlueprint*> Retargeted{ Task.GetRetargeted() };
+	const TSet<UBlueprint*> Rejected{ Task.GetRejected() };
+	TArray<UBlueprint*> Reparented;
+	for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
+	{
+		FRetargetItem* Item = ItemsByPath.FindChecked(Node.AssetData.ObjectPath);
+		if (!Node.Blueprint)
+		{
+			continue;
+		}
+
+		if (Retargeted.Contains(Node.Blueprint))
+		{
+			Item->Blueprint = Node.Blueprint;
+			Reparented.Add(Node.Blueprint);
+		}
+		else if (Rejected.Contains(Node.Blueprint))
+		{
+			Item->Result = TEXT("Incompatible");
+		}
+		else if (Node.NewParent)
+		{
+			Item->Result = TEXT("NotReparented");
+		}
+		else
+		{
+			Item->Result = TEXT("ParentNotRetargeted");
+		}
+	}
+
+	// Files on disk are still untouched. Back them up before saving over them
+	if (Backup && Reparented.Num() > 0)
+	{
+		bool bBackedUp = true;
+		for (UBlueprint* Blueprint : Reparented)
+		{
+			bBackedUp &= Backup->Add(Blueprint->GetOutermost()->GetFName());
+		}
+		if (!bBackedUp || !Backup->Save())
+		{
+			UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't backup blueprints. Nothing else was saved"));
+			return false;
+		}
+		UE_LOG(LogBlueprintReparent, Display, TEXT("Run with -restore=\"%s\" to undo this retarget"), *Backup->GetDirectory());
+	}
+
+	TMap<UPackage*, FRetargetItem*> ToSave;
+	for (FRetargetItem* Item : Items)
+	{
+		UBlueprint* Blueprint = Item->Blueprint;
+		if (!Blueprint)
+		{
+			continue;
+		}
+
+		if (Blueprint->Status == BS_Error)
+		{
+			Item->Result = TEXT("CompileFailed");
+		}
+		else if (!bSave)
+		{
+			Item->Result = TEXT("Reparented");
+		}
+		else
+		{
+			ToSave.Add(Blueprint->GetOutermost(), Item);
+		}
+	}
+
+	// The whole chunk is saved at once, so that file writes overlap
+	if (ToSave.Num() > 0)
+	{
+		TArray<UPackage*> Packages;
+		ToSave.GenerateKeyArray(Packages);
+
+		TArray<FName> PackageNames;
+		for (const UPackage* Package : Packages)
+		{
+			PackageNames.Add(Package->GetFName());
+		}
+		Journal.SetActive(PackageNames);
+		const FRetargetSaveResult SaveResult = FRetargetPackageSaver::Save(Packages);
+		for (const auto& Saved : ToSave)
+		{
+			Saved.Value->Result = SaveResult.Failed.Contains(Saved.Key) ? TEXT("SaveFailed") : TEXT("Saved");
+		}
+	}
+
+	// Results only in memory (E.g: -nosave) would be lost on a crash, so they are not done
+	for (const FRetargetItem* Item : Items)
+	{
+		if (Item->Result == TEXT("Saved"))
+		{
+			Journal.Record(Item->AssetData.PackageName, ERetargetJournalState::Saved, Item->NewParent);
+		}
+		else if (!HasSucceeded(*Item))
+		{
+			Journal.Record(Item->AssetData.PackageName, ERetargetJournalState::Failed, Item->Result);
+		}
+	}
+
+	if (bUnload)
+	{
+		// Release everything this chunk loaded. Blueprints not saved can't be retargeted again in this run anyway
+		for (FRetargetItem* Item : Items)
+		{
+			Item->Blueprint = nullptr;
+		}
+
+		TArray<UPackage*> Packages;
+		for (FRetargetItem* Item : Items)
+		{
+			if (UPackage* Package = FindPackage(nullptr, *Item->AssetData.PackageName.ToString()))
+			{
+				Packages.Add(Package);
+			}
+		}
+
+		RETARGET_PHASE_SCOPE(GarbageCollect, NAME_None);
+		UPackageTools::UnloadPackages(Packages);
+
+		// Filters hold classes of the blueprints just unloaded
+		SuggestionFilters.Reset();
+	}
+	return true;
+}
+
+void UBlueprintRetargetCommandlet::RunWorkers(const FString& Params, TArray<FRetargetItem>& Items, const TArray<int32>& PendingItems, const TArray<FName>& InSuspects, int32 NumWorkers, int32 Retries, int32 TimeoutMinutes, FRetargetBackup* Backup)
+{
+	TArray<FName> Suspects = InSuspects;
+	const FString WorkersDirectory = FPaths::ProjectSavedDir() / TEXT("BlueprintRetarget") / TEXT("Workers");
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const FString WorkerParams = GetWorkerParams(Params);
+
+	TMap<FName, FRetargetItem*> ItemsByPath;
+	TArray<FAssetData> Pending;
+	for (int32 ItemIndex : PendingItems)
+	{
+		ItemsByPath.Add(Items[ItemIndex].AssetData.ObjectPath, &Items[ItemIndex]);
+		Pending.Add(Items[ItemIndex].AssetData);
+	}
+
+	for (int32 Attempt = 0; Attempt <= Retries && Pending.Num() > 0; ++Attempt)
+	{
+		// Subtrees of the parent graph never get split, so a parent and its children are always in the same process
+		const TArray<TArray<FAssetData>> Shards = FRetargetHierarchy(Pending).SplitInShards(NumWorkers);
+		UE_LOG(LogBlueprintReparent, Display, TEXT("Retargeting %i blueprints with %i workers"), Pending.Num(), Shards.Num());
+
+		TArray<FProcHandle> Workers;
+		TArray<FString> ReportFiles;
+		TArray<FString> JournalFiles;
+		TArray<FString> BackupDirectories;
+		for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+		{
+			const FString Name = FString::Printf(TEXT("Worker%i_%i"), Attempt, ShardIndex);
+			const FString ShardFile = WorkersDirectory / Name + TEXT("_Shard.json");
+
+			// Suspects of the shard are retargeted alone by the worker too
+			TArray<TSharedPtr<FJsonValue>> ShardEntries;
+			TArray<TSharedPtr<FJsonValue>> SuspectEntries;
+			for (const FAssetData& AssetData : Shards[ShardIndex])
+			{
+				ShardEntries.Add(MakeShared<FJsonValueString>(AssetData.ObjectPath.ToString()));
+				if (Suspects.Contains(AssetData.PackageName))
+				{
+					SuspectEntries.Add(MakeShared<FJsonValueString>(AssetData.PackageName.ToString()));
+				}
+			}
+			TSharedRef<FJsonObject> Shard = MakeShared<FJsonObject>();
+			Shard->SetArrayField(TEXT("Blueprints"), ShardEntries);
+			Shard->SetArrayField(TEXT("Suspects"), SuspectEntries);
+
+			FString ShardText;
+			TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ShardText);
+			FJsonSerializer::Serialize(Shard, Writer);
+			FFileHelper::SaveStringToFile(ShardText, *ShardFile);
+
+			ReportFiles.Add(WorkersDirectory / Name + TEXT("_Report.json"));
+			IFileManager::Get().Delete(*ReportFiles.Last(), false, true, true);
+
+			JournalFiles.Add(WorkersDirectory / Name + TEXT("_Journal.log"));
+
+			FString Arguments = FString::Printf(TEXT("\"%s\" -run=BlueprintRetarget%s -shard=\"%s\" -report=\"%s\" -journal=\"%s\" -restart -abslog=\"%s\" -noredirect -unattended -nopause -nosplash -multiprocess"),
+				*ProjectFile, *WorkerParams, *ShardFile, *ReportFiles.Last(), *JournalFiles.Last(), *(WorkersDirectory / Name + TEXT(".log")));
+			if (Backup)
+			{
+				BackupDirectories.Add(Backup->GetDirectory() + TEXT("_") + Name);
+				Arguments += FString::Printf(TEXT(" -backup -backupdir=\"%s\""), *BackupDirectories.Last());
+			}
+			Workers.Add(FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Arguments, true, true, true, nullptr, 0, nullptr, nullptr));
+		}
+
+		// A hung worker would block the run forever. Past the deadline it gets killed, and its journal handled like a crash
+		const double Deadline = TimeoutMinutes > 0 ? FPlatformTime::Seconds() + TimeoutMinutes * 60.0 : 0.0;
+		for (int32 WorkerIndex = 0; WorkerIndex < Workers.Num(); ++WorkerIndex)
+		{
+			FProcHandle& Worker = Workers[WorkerIndex];
+			if (!Worker.IsValid())
+			{
+				UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't launch worker %i"), WorkerIndex);
+				continue;
+			}
+
+			bool bKilled = false;
+			while (FPlatformProcess::IsProcRunning(Worker))
+			{
+				const double Now = FPlatformTime::Seconds();
+				if (Deadline > 0.0 && Now > Deadline && !bKilled)
+				{
+					UE_LOG(LogBlueprintReparent, Error, TEXT("Worker %i didn't finish in %i minutes. It was killed"), WorkerIndex, TimeoutMinutes);
+					FPlatformProcess::TerminateProc(Worker, true);
+					bKilled = true;
+				}
+				else if (bKilled && Now > Deadline + WorkerKillSeconds)
+				{
+					UE_LOG(LogBlueprintReparent, Error, TEXT("Worker %i couldn't be killed"), WorkerIndex);
+					break;
+				}
+				FPlatformProcess::Sleep(WorkerPollSeconds);
+			}
+
+			if (!bKilled)
+			{
+				int32 ReturnCode = 0;
+				FPlatformProcess::GetProcReturnCode(Worker, &ReturnCode);
+				UE_LOG(LogBlueprintReparent, Display, TEXT("Worker %i finished (%i)"), WorkerIndex, ReturnCode);
+			}
+			FPlatformProcess::CloseProc(Worker);
+		}
+
+		for (const FString& ReportFile : ReportFiles)
+		{
+			MergeWorkerReport(ReportFile, ItemsByPath);
+		}
+
+		// Journals of crashed workers tell which blueprint they were retargeting. It is not tried again.
+		// If they were compiling several, these are retargeted alone on the next attempt
+		for (const FString& JournalFile : JournalFiles)
+		{
+			FRetargetJournalContents Contents;
+			if (!FRetargetJournal::Read(JournalFile, Contents) || Contents.bFinished || Contents.Active.Num() <= 0)
+			{
+				continue;
+			}
+			if (Contents.Active.Num() > 1)
+			{
+				for (const FName& Package : Contents.Active)
+				{
+					Suspects.AddUnique(Package);
+				}
+				continue;
+			}
+
+			for (const auto& Item : ItemsByPath)
+			{
+				if (Item.Value->AssetData.PackageName == Contents.Active[0] && Item.Value->Result.IsEmpty())
+				{
+					UE_LOG(LogBlueprintReparent, Warning, TEXT("A worker crashed retargeting %s. It is quarantined"), *Item.Key.ToString());
+					Item.Value->Result = TEXT("Quarantined");
+				}
+			}
+		}
+		for (const FString& BackupDirectory : BackupDirectories)
+		{
+			Backup->Merge(BackupDirectory);
+		}
+
+		// Blueprints of crashed workers and failures that can be transient are tried again
+		Pending.Reset();
+		for (const auto& Item : ItemsByPath)
+		{
+			const FString& Result = Item.Value->Result;
+			if (Result.IsEmpty() || Result == TEXT("LoadFailed") || Result == TEXT("CompileFailed") || Result == TEXT("SaveFailed"))
+			{
+				Pending.Add(Item.Value->AssetData);
+			}
+		}
+	}
+
+	if (Backup && Backup->Num() > 0 && Backup->Save())
+	{
+		UE_LOG(LogBlueprintReparent, Display, TEXT("Run with -restore=\"%s\" to undo this retarget"), *Backup->GetDirectory());
+	}
+
+	for (const auto& Item : ItemsByPath)
+	{
+		if (Item.Value->Result.IsEmpty())
+		{
+			Item.Value->Result = TEXT("WorkerFailed");
+		}
+
+		if (Item.Value->Result == TEXT("Saved"))
+		{
+			Journal.Record(Item.Value->AssetData.PackageName, ERetargetJournalState::Saved, Item.Value->NewParent);
+		}
+		else if (Item.Value->Result == TEXT("Quarantined"))
+		{
+			Journal.Record(Item.Value->AssetData.PackageName, ERetargetJournalState::Quarantined, TEXT("Crashed a worker"));
+		}
+		else if (!HasSucceeded(*Item.Value))
+		{
+			Journal.Record(Item.Value->AssetData.PackageName, ERetargetJournalState::Failed, Item.Value->Result);
+		}
+	}
+}
+
+void UBlueprintRetargetCommandlet::MergeWorkerReport(const FString& ReportFile, const TMap<FName, FRetargetItem*>& ItemsByPath) const
+{
+	FString ReportText;
+	TSharedPtr<FJsonObject> Report;
+	const TArray<TSharedPtr<FJsonValue>>* Entries;
+	if (!FFileHelper::LoadFileToString(ReportText, *ReportFile) ||
+		!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(ReportText), Report) || !Report.IsValid() ||
+		!Report->TryGetArrayField(TEXT("Blueprints"), Entries))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't read worker report '%s'"), *ReportFile);
+		return;
+	}
+
+	for (const TSharedPtr<FJsonValue>& Value : *Entries)
+	{
+		const TSharedPtr<FJsonObject>* Entry;
+		if (!Value->TryGetObject(Entry))
+		{
+			continue;
+		}
+
+		if (FRetargetItem* const* Item = ItemsByPath.Find(FName(*(*Entry)->GetStringField(TEXT("Blueprint")))))
+		{
+			(*Item)->NewParent = (*Entry)->GetStringField(TEXT("NewParent"));
+			(*Item)->Result = (*Entry)->GetStringField(TEXT("Result"));
+		}
+	}
+}
+
+FString UBlueprintRetargetCommandlet::GetWorkerParams(const FString& Params)
+{
+	// Options that only make sense for the coordinator, or that it sets for each worker
+	static const TCHAR* CoordinatorSwitches[] = {
+		TEXT("run"), TEXT("workers"), TEXT("retries"), TEXT("report"), TEXT("csv"),
+		TEXT("backup"), TEXT("backupdir"), TEXT("shard"), TEXT("abslog"), TEXT("patch"), TEXT("verify"),
+		TEXT("referencers"), TEXT("journal"), TEXT("restart"), TEXT("workertimeout")
+	};
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	ParseCommandLine(*Params, Tokens, Switches);
+
+	FString WorkerParams;
+	for (const FString& Switch : Switches)
+	{
+		FString Key = Switch;
+		FString Value;
+		const bool bHasValue = Switch.Split(TEXT("="), &Key, &Value);
+		if (Algo::FindByPredicate(CoordinatorSwitches, [&Key](const TCHAR* Name) { return Key.Equals(Name, ESearchCase::IgnoreCase); }))
+		{
+			continue;
+		}
+
+		WorkerParams += bHasValue ? FString::Printf(TEXT(" -%s=\"%s\""), *Key, *Value.TrimQuotes()) : TEXT(" -") + Key;
+	}
+	return WorkerParams;
+}
+
+bool UBlueprintRetargetCommandlet::LoadShard(const FString& ShardFile, TSet<FName>& OutBlueprints, TArray<FName>& OutSuspects) const
+{
+	FString ShardText;
+	TSharedPtr<FJsonObject> Shard;
+	const TArray<TSharedPtr<FJsonValue>>* Entries;
+	if (!FFileHelper::LoadFileToString(ShardText, *ShardFile) ||
+		!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(ShardText), Shard) || !Shard.IsValid() ||
+		!Shard->TryGetArrayField(TEXT("Blueprints"), Entries))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't read shard file '%s'"), *ShardFile);
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& Entry : *Entries)
+	{
+		OutBlueprints.Add(FName(*Entry->AsString()));
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* SuspectEntries;
+	if (Shard->TryGetArrayField(TEXT("Suspects"), SuspectEntries))
+	{
+		for (const TSharedPtr<FJsonValue>& Entry : *SuspectEntries)
+		{
+			OutSuspects.Add(FName(*Entry->AsString()));
+		}
+	}
+	return true;
+}
+
+UBlueprint* UBlueprintRetargetCommandlet::LoadRetarget(FRetargetItem& Item, UClass*& OutNewParent)
+{
+	// Children of broken blueprints keep their parent
+	const bool bNeedsParent = FRetargetUtils::HasMissingParent(Item.AssetData);
+	if (bNeedsParent && Item.NewParent.IsEmpty())
+	{
+		Item.NewParent = Mappings.FindRef(Item.OldParent);
+	}
+
+	UClass* NewClass = nullptr;
+	if (bNeedsParent && !Item.NewParent.IsEmpty())
+	{
+		// Classes can be unloaded along with a chunk
+		TWeakObjectPtr<UClass>& CachedClass = NewClasses.FindOrAdd(Item.NewParent);
+		if (!CachedClass.IsValid())
+		{
+			CachedClass = LoadObject<UClass>(nullptr, *Item.NewParent);
+		}
+		NewClass = CachedClass.Get();
+
+		if (!NewClass)
+		{
+			Item.Result = TEXT("ClassNotFound");
+			return nullptr;
+		}
+	}
+
+	UBlueprint* Blueprint = nullptr;
+	{
+		RETARGET_PHASE_SCOPE(Load, Item.AssetData.PackageName);
+		Journal.SetActive({ Item.AssetData.PackageName });
+		Blueprint = Cast<UBlueprint>(Item.AssetData.GetAsset());
+	}
+	if (!Blueprint)
+	{
+		Item.Result = TEXT("LoadFailed");
+		return nullptr;
+	}
+
+	if (bNeedsParent && !NewClass)
+	{
+		NewClass = SuggestClass(Item.AssetData, Blueprint, MinSuggestionScore);
+		if (!NewClass)
+		{
+			Item.Result = TEXT("NoSuggestion");
+			return nullptr;
+		}
+		Item.NewParent = NewClass->GetPathName();
+	}
+
+	OutNewParent = NewClass;
+	return Blueprint;
+}
+
+int32 UBlueprintRetargetCommandlet::RestoreBackup(const FString& BackupDirectory) const
+{
+	const FString Directory = BackupDirectory.IsEmpty() ? FRetargetBackup::FindLatest() : BackupDirectory;
+	if (Directory.IsEmpty())
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("There are no retarget backups to restore"));
+		return 1;
+	}
+	return FRetargetBackup::Restore(Directory) > 0 ? 0 : 1;
+}
+
+int32 UBlueprintRetargetCommandlet::ScanPackages(const FString& RootPath, const FString& ReportFile) const
+{
+	const TArray<FScannedBlueprint> Broken = FRetargetPackageScanner::FindBrokenBlueprints(RootPath);
+
+	TArray<TSharedPtr<FJsonValue>> ReportEntries;
+	for (const FScannedBlueprint& Blueprint : Broken)
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("%s has a missing parent: %s"), *Blueprint.PackageName.ToString(), *Blueprint.ParentClassPath);
+
+		TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+		Entry->SetStringField(TEXT("Package"), Blueprint.PackageName.ToString());
+		Entry->SetStringField(TEXT("Filename"), Blueprint.Filename);
+		Entry->SetStringField(TEXT("OldParent"), Blueprint.ParentClassPath);
+		ReportEntries.Add(MakeShared<FJsonValueObject>(Entry));
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("Broken"), Broken.Num());
+	Report->SetArrayField(TEXT("Blueprints"), ReportEntries);
+
+	FString ReportText;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ReportText);
+	FJsonSerializer::Serialize(Report, Writer);
+	if (!FFileHelper::SaveStringToFile(ReportText, *ReportFile))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't write report to '%s'"), *ReportFile);
+	}
+	return Broken.Num() > 0 ? 1 : 0;
+}
+
+bool UBlueprintRetargetCommandlet::LoadMappings(const FString& MapFile, TMap<FString, FString>& OutMappings, FString& OutHash) const
+{
+	FString MapPath = MapFile;
+	if (FPaths::IsRelative(MapPath))
+	{
+		MapPath = FPaths::Combine(FPaths::ProjectDir(), MapPath);
+	}
+
+	FString MapText;
+	if (!FFileHelper::LoadFileToString(MapText, *MapPath))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't read mapping file '%s'"), *MapPath);
+		return false;
+	}
+	OutHash = FMD5::HashAnsiString(*MapText);
+
+	TSharedPtr<FJsonObject> MapObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(MapText);
+	if (!FJsonSerializer::Deserialize(Reader, MapObject) || !MapObject.IsValid())
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Mapping file '%s' is not a valid json object"), *MapPath);
+		return false;
+	}
+
+	for (const auto& Mapping : MapObject->Values)
+	{
+		FString NewParent;
+		if (!Mapping.Value.IsValid() || !Mapping.Value->TryGetString(NewParent))
+		{
+			UE_LOG(LogBlueprintReparent, Warning, TEXT("Ignored mapping '%s': new parent must be a class path"), *Mapping.Key);
+			continue;
+		}
+		OutMappings.Add(FPackageName::ExportTextPathToObjectPath(Mapping.Key), FPackageName::ExportTextPathToObjectPath(NewParent));
+	}
+	return OutMappings.Num() > 0;
+}
+
+void UBlueprintRetargetCommandlet::FindBrokenBlueprints(const FString& RootPath, const TMap<FString, FString>& Mappings, bool bIncludeUnmapped, TArray<FAssetData>& OutBlueprints) const
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.ClassNames.Add(UBlueprint::StaticClass()->GetFName());
+	Filter.bRecursiveClasses = true;
+	Filter.PackagePaths.Add(FName(*RootPath));
+	Filter.bRecursivePaths = true;
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssets(Filter, Assets);
+	Assets.RemoveAll([](const FAssetData& AssetData) {
+		return !FRetargetUtils::IsInvalidBlueprint(AssetData);
+	});
+
+	// Only blueprints whose own parent is missing get a new one. Broken blueprints inheriting from them keep their parent
+	const FRetargetHierarchy Hierarchy{ Assets };
+	for (const TArray<int32>& Batch : Hierarchy.Batches)
+	{
+		const FAssetData& Root = Hierarchy.Nodes[Batch[0]].AssetData;
+		const FString ParentClassPath = FRetargetUtils::GetParentClassPath(Root);
+
+		bool bRetarget = false;
+		if (FRetargetUtils::HasMissingParent(Root))
+		{
+			bRetarget = bIncludeUnmapped || Mappings.Contains(ParentClassPath);
+		}
+		else
+		{
+			// Its parent blueprint was fixed already (E.g: by a previous run). It only needs to be recompiled
+			FString ParentBlueprintPath = ParentClassPath;
+			ParentBlueprintPath.RemoveFromEnd(TEXT("_C"));
+			bRetarget = !FRetargetUtils::IsInvalidBlueprint(AssetRegistry.GetAssetByObjectPath(FName(*ParentBlueprintPath)));
+		}
+
+		if (bRetarget)
+		{
+			for (int32 Index : Batch)
+			{
+				OutBlueprints.Add(Hierarchy.Nodes[Index].AssetData);
+			}
+		}
+	}
+}
+
+TArray<FMovedParent> UBlueprintRetargetCommandlet::FindMovedParents(const TArray<FAssetData>& Blueprints, const TMap<FString, FString>& Mappings, bool bFindMoved) const
+{
+	TMap<FString, TArray<FAssetData>> BlueprintsByMissingParent;
+	for (const FAssetData& AssetData : Blueprints)
+	{
+		// Children of broken blueprints are fixed along with their parent
+		if (FRetargetUtils::HasMissingParent(AssetData))
+		{
+			BlueprintsByMissingParent.FindOrAdd(FRetargetUtils::GetParentClassPath(AssetData)).Add(AssetData);
+		}
+	}
+
+	TArray<FMovedParent> MovedParents;
+	for (auto& Group : BlueprintsByMissingParent)
+	{
+		UClass* NewClass = nullptr;
+		if (const FString* MappedParent = Mappings.Find(Group.Key))
+		{
+			// A mapping is only a rename if the class name stays the same
+			if (FRetargetRedirects::HaveSameName(Group.Key, *MappedParent))
+			{
+				NewClass = LoadObject<UClass>(nullptr, **MappedParent);
+			}
+		}
+		else if (bFindMoved)
+		{
+			NewClass = FRetargetRedirects::FindMovedClass(Group.Key);
+		}
+
+		if (NewClass && FRetargetRedirects::HasMatchingLayout(NewClass, Group.Value))
+		{
+			FMovedParent& Moved = MovedParents.AddDefaulted_GetRef();
+			Moved.OldPath = Group.Key;
+			Moved.NewClass = NewClass;
+			Moved.Blueprints = MoveTemp(Group.Value);
+		}
+	}
+	return MovedParents;
+}
+
+void UBlueprintRetargetCommandlet::RedirectMovedParents(const TArray<FMovedParent>& MovedParents, TMap<FName, FString>& OutRedirected) const
+{
+	for (const FMovedParent& Moved : MovedParents)
+	{
+		if (FRetargetRedirects::AddClassRedirect(Moved.OldPath, Moved.NewClass->GetPathName()))
+		{
+			for (const FAssetData& AssetData : Moved.Blueprints)
+			{
+				OutRedirected.Add(AssetData.ObjectPath, Moved.NewClass->GetPathName());
+			}
+		}
+	}
+}
+
+void UBlueprintRetargetCommandlet::PatchMovedParents(const TArray<FMovedParent>& MovedParents, int32 NumVerify, TMap<FName, FString>& OutPatched) const
+{
+	// Patched files are always backed up, since nothing can be undone after
+	FRetargetBackup Backup;
+	TArray<TPair<const FMovedParent*, FAssetData>> Candidates;
+	for (const FMovedParent& Moved : MovedParents)
+	{
+		for (const FAssetData& AssetData : Moved.Blueprints)
+		{
+			if (Backup.Add(AssetData.PackageName))
+			{
+				Candidates.Emplace(&Moved, AssetData);
+			}
+		}
+	}
+	if (Candidates.Num() == 0 || !Backup.Save())
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<TPair<UClass*, FAssetData>> Patched;
+	TArray<FString> PatchedFiles;
+	for (const auto& Candidate : Candidates)
+	{
+		FString Filename;
+		FString Error;
+		if (FPackageName::DoesPackageExist(Candidate.Value.PackageName.ToString(), nullptr, &Filename) &&
+			FRetargetPackagePatcher::PatchParentClass(Filename, Candidate.Key->OldPath, Candidate.Key->NewClass, Error))
+		{
+			Patched.Emplace(Candidate.Key->NewClass, Candidate.Value);
+			PatchedFiles.Add(Filename);
+		}
+		else
+		{
+			UE_LOG(LogBlueprintReparent, Warning, TEXT("Couldn't patch %s, it will be retargeted normally: %s"), *Candidate.Value.ObjectPath.ToString(), *Error);
+		}
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetRegistry.ScanModifiedAssetFiles(PatchedFiles);
+
+	// Load a sample spread over all patched blueprints. Any failure undoes every patch
+	const int32 Step = NumVerify > 0 ? FMath::Max(1, Patched.Num() / NumVerify) : 1;
+	TArray<UPackage*> Loaded;
+	bool bVerified = true;
+	for (int32 Index = 0; Index < Patched.Num() && bVerified; Index += Step)
+	{
+		const UBlueprint* Blueprint = LoadObject<UBlueprint>(nullptr, *Patched[Index].Value.ObjectPath.ToString());
+		bVerified = Blueprint && Blueprint->ParentClass == Patched[Index].Key && Blueprint->Status != BS_Error;
+		if (!bVerified)
+		{
+			UE_LOG(LogBlueprintReparent, Error, TEXT("Patched blueprint %s failed to load with its new parent"), *Patched[Index].Value.ObjectPath.ToString());
+		}
+		if (Blueprint)
+		{
+			Loaded.Add(Blueprint->GetOutermost());
+		}
+	}
+	UPackageTools::UnloadPackages(Loaded);
+
+	if (!bVerified)
+	{
+		// The registry read the patched parents. Blueprints must be found again with their missing one
+		FRetargetBackup::Restore(Backup.GetDirectory());
+		AssetRegistry.ScanModifiedAssetFiles(PatchedFiles);
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Patches were undone. Blueprints will be reparented instead"));
+		return;
+	}
+
+	for (const auto& Entry : Patched)
+	{
+		OutPatched.Add(Entry.Value.ObjectPath, Entry.Key->GetPathName());
+	}
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Patched %i blueprints in %.2fs. Run with -restore=\"%s\" to undo it"),
+		Patched.Num(), FPlatformTime::Seconds() - StartTime, *Backup.GetDirectory());
+}
+
+UClass* UBlueprintRetargetCommandlet::SuggestClass(const FAssetData& AssetData, const UBlueprint* Blueprint, float MinScore)
+{
+	const FString MissingParentPath = FRetargetUtils::GetParentClassPath(AssetData);
+
+	// Blueprints of the same kind and missing parent share the same filter
+	const FString FilterKey = FRetargetBlueprintFilter::GetGroupKey(AssetData);
+	TSharedRef<FRetargetBlueprintFilter>* Filter = SuggestionFilters.Find(FilterKey);
+	if (!Filter)
+	{
+		Filter = &SuggestionFilters.Add(FilterKey, FRetargetBlueprintFilter::Create({ AssetData }));
+	}
+
+	FParentMemberUsage Usage;
+	Usage.Gather(Blueprint);
+
+	const TArray<FRetargetSuggestion> Suggestions = FRetargetSuggestions::Get().Suggest(MissingParentPath, Usage, &Filter->Get(), 1);
+	if (Suggestions.Num() > 0 && Suggestions[0].Score >= MinScore)
+	{
+		UE_LOG(LogBlueprintReparent, Display, TEXT("Suggested %s as new parent of %s (score %.2f)"), *Suggestions[0].Class->GetPathName(), *AssetData.ObjectPath.ToString(), Suggestions[0].Score);
+		return Suggestions[0].Class.Get();
+	}
+	return nullptr;
+}
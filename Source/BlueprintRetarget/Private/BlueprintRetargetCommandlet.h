@@ -0,0 +1,160 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Commandlets/Commandlet.h>
+
+#include "BlueprintRetargeter.h"
+#include "RetargetJournal.h"
+
+#include "BlueprintRetargetCommandlet.generated.h"
+
+struct FAssetData;
+class UBlueprint;
+class FRetargetBlueprintFilter;
+class FRetargetBackup;
+struct FRetargetItem;
+struct FMovedParent;
+class FJsonObject;
+
+
+/**
+ * Retargets broken blueprints without any user interaction.
+ *
+ * Usage: UE4Editor-Cmd.exe Project.uproject -run=BlueprintRetarget -map=Retarget.json [-report=Report.json] [-path=/Game] [-nosave]
+ *        [-suggest [-minscore=0.8]] [-noredirect] [-csv=Stats.csv] [-backup] [-chunkmb=4096] [-strict]
+ *        [-patch [-verify=10]] [-referencers] [-journal=Journal.log] [-restart]
+ *        [-workers=4 [-retries=1] [-workertimeout=240]]
+ *        UE4Editor-Cmd.exe Project.uproject -run=BlueprintRetarget -restore[=BackupFolder]
+ *        UE4Editor-Cmd.exe Project.uproject -run=BlueprintRetarget -scan [-report=Report.json] [-path=/Game]
+ *
+ * The map file is a json object of old parent class paths to new parent class paths:
+ * { "/Script/OldModule.MyActor": "/Script/NewModule.MyActor" }
+ *
+ * Blueprints only broken because they inherit from a broken blueprint keep their parent, and are compiled after it.
+ *
+ * With -suggest, blueprints whose missing parent has no mapping get the best suggested parent, if its score is at least minscore.
+ *
+ * Parents that were only renamed or moved (same class name) get a class redirect instead, so their blueprints
+ * are not loaded or saved. Use -noredirect to always reparent.
+ *
+ * With -patch, these blueprints get their new parent written directly in their package files instead of a redirect.
+ * Patched files are always backed up, and -verify of them are loaded to check the result. 0 loads all of them.
+ *
+ * Blueprints are analyzed before being modified, and nodes that would break with the new parent are logged.
+ * With -strict, these blueprints are not reparented.
+ *
+ * With -referencers, blueprints that depend on the retargeted ones are recompiled and saved after, in dependency order.
+ * Blueprints whose dependencies didn't change are skipped. Levels and other assets depending on them are listed in the report.
+ *
+ * With -workers, independent parent/child subtrees are split in shards, each one retargeted by its own editor process.
+ * Their reports and backups are merged, and blueprints that failed are tried again.
+ *
+ * A table with the time spent on each phase is logged at the end. -csv writes it for every blueprint.
+ *
+ * Package files are checked out from source control in a single request before anything is modified. Blueprints that
+ * can't be checked out are skipped. Saved packages get their files written in parallel.
+ *
+ * The state of every blueprint is recorded on a journal as it goes. If a run crashes or gets killed, the next one resumes it:
+ * finished blueprints are skipped, and the one being retargeted when it stopped is quarantined. If several were being
+ * compiled together, they are retargeted one at a time instead. -restart ignores the journal.
+ *
+ * With -backup, package files are copied to Saved/BlueprintRetarget/Backups before being saved. -restore copies them back.
+ *
+ * -scan only reports broken blueprints, reading package headers directly. It doesn't load them or trust asset registry tags.
+ *
+ * Blueprints are loaded in chunks of an estimated -chunkmb megabytes of memory, and unloaded after being saved.
+ * 0 loads all of them at once.
+ */
+UCLASS()
+class UBlueprintRetargetCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UBlueprintRetargetCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+
+	/** Old parent class path -> New parent class path */
+	TMap<FString, FString> Mappings;
+
+	/** Cached new parents by path */
+	TMap<FString, TWeakObjectPtr<UClass>> NewClasses;
+
+	/** Filters by group key. Reset when blueprints get unloaded */
+	TMap<FString, TSharedRef<FRetargetBlueprintFilter>> SuggestionFilters;
+
+	FBlueprintRetargeter Retargeter{ false };
+	FRetargetJournal Journal;
+
+	float MinSuggestionScore = 0.8f;
+	bool bSave = true;
+
+
+	/**
+	 * Reparents, compiles and saves a group of blueprints. Children are restored to their parent and compiled after it.
+	 * @return false if the run must stop
+	 */
+	bool RetargetChunk(const TArray<FRetargetItem*>& Items, FRetargetBackup* Backup, bool bUnload);
+
+	/**
+	 * Splits pending blueprints in dependency-safe shards, retargets each one in a separate editor process and
+	 * merges their results. Failed blueprints are tried again up to Retries times, except the one a worker crashed on.
+	 * Suspects of a crash are retargeted alone by their worker, still after their parents.
+	 * @param TimeoutMinutes workers still running this long after an attempt starts are killed, like a crash. 0 waits forever
+	 */
+	void RunWorkers(const FString& Params, TArray<FRetargetItem>& Items, const TArray<int32>& PendingItems, const TArray<FName>& InSuspects, int32 NumWorkers, int32 Retries, int32 TimeoutMinutes, FRetargetBackup* Backup);
+
+	void MergeWorkerReport(const FString& ReportFile, const TMap<FName, FRetargetItem*>& ItemsByPath) const;
+
+	/** @return command line options of the coordinator that workers also need */
+	static FString GetWorkerParams(const FString& Params);
+
+	/**
+	 * Recompiles blueprints that depend on the retargeted ones, and saves them. Adds them to the report.
+	 * @return number of referencers that failed
+	 */
+	int32 RecompileReferencers(const TArray<FRetargetItem>& Items, FRetargetBackup* Backup, FJsonObject& Report) const;
+
+	/** Reads the object paths of the blueprints a worker has to retarget, and the packages it has to retarget alone */
+	bool LoadShard(const FString& ShardFile, TSet<FName>& OutBlueprints, TArray<FName>& OutSuspects) const;
+
+	/**
+	 * Loads a blueprint and, if its own parent is missing, finds its new parent. Children of broken blueprints keep theirs.
+	 * Sets the result of the item if it failed
+	 */
+	UBlueprint* LoadRetarget(FRetargetItem& Item, UClass*& OutNewParent);
+
+	int32 RestoreBackup(const FString& BackupDirectory) const;
+
+	/** Reports broken blueprints without loading them. @return 1 if any was found */
+	int32 ScanPackages(const FString& RootPath, const FString& ReportFile) const;
+
+	/** @param OutHash identifies the contents of the file, so that a journal is only resumed with the same mappings */
+	bool LoadMappings(const FString& MapFile, TMap<FString, FString>& OutMappings, FString& OutHash) const;
+
+	/**
+	 * Finds blueprints whose own parent is missing, and the broken blueprints inheriting from them.
+	 * Unless bIncludeUnmapped, only blueprints whose missing parent has a mapping are included.
+	 */
+	void FindBrokenBlueprints(const FString& RootPath, const TMap<FString, FString>& Mappings, bool bIncludeUnmapped, TArray<FAssetData>& OutBlueprints) const;
+
+	/** @return missing parents that only changed path, and can be replaced without touching their blueprints */
+	TArray<FMovedParent> FindMovedParents(const TArray<FAssetData>& Blueprints, const TMap<FString, FString>& Mappings, bool bFindMoved) const;
+
+	/** Adds class redirects for moved parents. Outputs the new parent of each redirected blueprint */
+	void RedirectMovedParents(const TArray<FMovedParent>& MovedParents, TMap<FName, FString>& OutRedirected) const;
+
+	/**
+	 * Rewrites the parent import of the package files of blueprints with moved parents, then loads NumVerify of them
+	 * to check the result. Outputs the new parent of each patched blueprint
+	 */
+	void PatchMovedParents(const TArray<FMovedParent>& MovedParents, int32 NumVerify, TMap<FName, FString>& OutPatched) const;
+
+	UClass* SuggestClass(const FAssetData& AssetData, const UBlueprint* Blueprint, float MinScore);
+};
@@ -0,0 +1,684 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "BlueprintRetargeter.h"
+#include "BlueprintRetarget.h"
+#include "RetargetHierarchy.h"
+#include "RetargetStats.h"
+#include "RetargetCompatibility.h"
+#include "RetargetSuggestions.h"
+#include "RetargetJournal.h"
+#include "RetargetUtils.h"
+
+#include <Styling/CoreStyle.h>
+#include <Framework/Application/SlateApplication.h>
+#include <Framework/Notifications/NotificationManager.h>
+#include <Widgets/Notifications/SNotificationList.h>
+#include <Dialogs/Dialogs.h>
+
+#include <Engine/Blueprint.h>
+#include <Engine/BlueprintGeneratedClass.h>
+#include <Kismet2/KismetEditorUtilities.h>
+#include <Kismet2/CompilerResultsLog.h>
+#include <Kismet2/BlueprintEditorUtils.h>
+#include <BlueprintCompilationManager.h>
+#include <EdGraphSchema_K2.h>
+#include <K2Node_CallFunction.h>
+#include <K2Node_CallParentFunction.h>
+#include <K2Node_ComponentBoundEvent.h>
+#include <K2Node_Event.h>
+#include <K2Node_FunctionEntry.h>
+#include <K2Node_Self.h>
+#include <K2Node_Variable.h>
+#include <Algo/StableSort.h>
+#include <HAL/IConsoleManager.h>
+
+#include <GameFramework/Actor.h>
+#include <Components/SceneComponent.h>
+#include <Engine/SCS_Node.h>
+#include <Engine/SimpleConstructionScript.h>
+
+
+#define LOCTEXT_NAMESPACE "BlueprintRetarget"
+
+
+static TAutoConsoleVariable<bool> CVarFullRefresh(
+	TEXT("BlueprintRetarget.FullRefresh"),
+	false,
+	TEXT("If true, all nodes of a blueprint are reconstructed when reparenting it, and it is always updated again after compiling"));
+
+
+FInheritedLayout::FInheritedLayout(const UClass* Class)
+{
+	if (!Class)
+	{
+		return;
+	}
+	bValid = true;
+
+	// Blueprint parents can have their root in the construction script, native ones in their default object
+	const USceneComponent* Root = nullptr;
+	const UBlueprintGeneratedClass* BlueprintClass = Cast<UBlueprintGeneratedClass>(Class);
+	if (BlueprintClass && BlueprintClass->SimpleConstructionScript)
+	{
+		USCS_Node* RootNode = nullptr;
+		Root = BlueprintClass->SimpleConstructionScript->GetSceneRootComponentTemplate(&RootNode);
+		RootComponent = RootNode ? RootNode->GetVariableName() : NAME_None;
+	}
+	if (!Root)
+	{
+		const AActor* Actor = Cast<AActor>(Class->GetDefaultObject(false));
+		Root = Actor ? Actor->GetRootComponent() : nullptr;
+		RootComponent = Root ? Root->GetFName() : NAME_None;
+	}
+	RootComponentClass = Root ? Root->GetClass()->GetFName() : NAME_None;
+
+	for (const UClass* Super = Class; Super; Super = Super->GetSuperClass())
+	{
+		for (const FImplementedInterface& Interface : Super->Interfaces)
+		{
+			if (Interface.Class)
+			{
+				Interfaces.Add(Interface.Class->GetFName());
+			}
+		}
+	}
+
+	for (TFieldIterator<UFunction> It(Class, EFieldIteratorFlags::IncludeSuper); It; ++It)
+	{
+		if (UEdGraphSchema_K2::CanKismetOverrideFunction(*It))
+		{
+			OverridableFunctions.Add(It->GetFName());
+		}
+	}
+}
+
+bool FInheritedLayout::Matches(const FInheritedLayout& Other) const
+{
+	return bValid && Other.bValid &&
+		RootComponent == Other.RootComponent && RootComponentClass == Other.RootComponentClass &&
+		Interfaces.Num() == Other.Interfaces.Num() && Interfaces.Includes(Other.Interfaces) &&
+		OverridableFunctions.Num() == Other.OverridableFunctions.Num() && OverridableFunctions.Includes(Other.OverridableFunctions);
+}
+
+
+bool FBlueprintRetargeter::ReparentBlueprint(UBlueprint* Blueprint, UClass* ChosenClass)
+{
+	TArray<TPair<UBlueprint*, UClass*>> Reparents{ { Blueprint, ChosenClass } };
+	const bool bReparent = ConfirmReparents(Reparents) && Reparents.Num() > 0 && BeginReparent(Blueprint, ChosenClass);
+	if (bReparent)
+	{
+		Compile(Blueprint);
+		EndReparent(Blueprint);
+	}
+
+	if (bInteractive && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().DismissAllMenus();
+	}
+	return bReparent;
+}
+
+TArray<UBlueprint*> FBlueprintRetargeter::ReparentBlueprints(const TArray<UBlueprint*>& Blueprints, UClass* ChosenClass)
+{
+	TArray<TPair<UBlueprint*, UClass*>> Reparents;
+	for (UBlueprint* Blueprint : Blueprints)
+	{
+		Reparents.Emplace(Blueprint, ChosenClass);
+	}
+
+	TArray<UBlueprint*> Reparented;
+	if (ConfirmReparents(Reparents))
+	{
+		for (const auto& Reparent : Reparents)
+		{
+			if (BeginReparent(Reparent.Key, Reparent.Value))
+			{
+				Reparented.Add(Reparent.Key);
+			}
+		}
+	}
+
+	CompileBlueprints(Reparented);
+
+	for (UBlueprint* Blueprint : Reparented)
+	{
+		EndReparent(Blueprint);
+	}
+
+	if (bInteractive && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().DismissAllMenus();
+	}
+	return Reparented;
+}
+
+TArray<UBlueprint*> FBlueprintRetargeter::ReparentHierarchy(FRetargetHierarchy& Hierarchy)
+{
+	FRetargetHierarchyTask Task{ *this, Hierarchy };
+	while (Task.Step()) {}
+	return Task.GetRetargeted();
+}
+
+bool FBlueprintRetargeter::BeginReparent(UBlueprint* Blueprint, UClass* ChosenClass)
+{
+	check(Blueprint);
+
+	if ((Blueprint == nullptr) || (ChosenClass == nullptr) || (ChosenClass == Blueprint->ParentClass))
+	{
+		return false;
+	}
+
+	UE_LOG(LogBlueprintReparent, Warning, TEXT("Reparenting blueprint %s from %s to %s..."), *Blueprint->GetFullName(), Blueprint->ParentClass ? *Blueprint->ParentClass->GetName() : TEXT("[None]"), *ChosenClass->GetName());
+	SetActive({ Blueprint });
+
+	const UClass* OldParent = Blueprint->ParentClass;
+	Blueprint->ParentClass = ChosenClass;
+	OldParentLayouts.Add(Blueprint, FInheritedLayout(OldParent));
+
+	// Ensure that the Blueprint is up-to-date (valid SCS etc.) before compiling
+	EnsureBlueprintIsUpToDate(Blueprint);
+	RefreshAffectedNodes(Blueprint, OldParent);
+	FBlueprintEditorUtils::MarkBlueprintAsModified(Blueprint);
+
+	INC_DWORD_STAT(STAT_BlueprintRetarget_NumReparented);
+	if (Journal)
+	{
+		Journal->Record(Blueprint->GetOutermost()->GetFName(), ERetargetJournalState::Reparented, ChosenClass->GetPathName());
+	}
+	return true;
+}
+
+void FBlueprintRetargeter::EndReparent(UBlueprint* Blueprint)
+{
+	SetActive({ Blueprint });
+
+	// Ensure that the Blueprint is up-to-date (valid SCS etc.) after compiling (new parent class)
+	FInheritedLayout OldParentLayout;
+	const bool bHasOldParent = OldParentLayouts.RemoveAndCopyValue(Blueprint, OldParentLayout);
+	if (CVarFullRefresh.GetValueOnGameThread() || NeedsUpdateAfterCompile(Blueprint, bHasOldParent ? &OldParentLayout : nullptr))
+	{
+		EnsureBlueprintIsUpToDate(Blueprint);
+	}
+
+	if (Blueprint->NativizationFlag != EBlueprintNativizationFlag::Disabled)
+	{
+		UBlueprint* ParentBlueprint = UBlueprint::GetBlueprintFromClass(Blueprint->ParentClass);
+		if (ParentBlueprint && ParentBlueprint->NativizationFlag == EBlueprintNativizationFlag::Disabled)
+		{
+			ParentBlueprint->NativizationFlag = EBlueprintNativizationFlag::Dependency;
+
+			if (bInteractive)
+			{
+				FNotificationInfo Warning(FText::Format(
+					LOCTEXT("InterfaceFlaggedForNativization", "{0} flagged for nativization (as a required dependency)."),
+					FText::FromName(ParentBlueprint->GetFName())
+				));
+				Warning.ExpireDuration = 5.0f;
+				Warning.bFireAndForget = true;
+				Warning.Image = FCoreStyle::Get().GetBrush(TEXT("MessageLog.Warning"));
+				FSlateNotificationManager::Get().AddNotification(Warning);
+			}
+		}
+	}
+
+	/*if (SCSEditor.IsValid())
+	{
+		SCSEditor->UpdateTree();
+	}*/
+}
+
+void FBlueprintRetargeter::RestoreParent(UBlueprint* Blueprint, UClass* ParentClass)
+{
+	SetActive({ Blueprint });
+
+	// The parent may have been retargeted in place. What it had before is unknown
+	OldParentLayouts.Remove(Blueprint);
+	if (ParentClass && Blueprint->ParentClass != ParentClass)
+	{
+		const UClass* OldParent = Blueprint->ParentClass;
+		Blueprint->ParentClass = ParentClass;
+		EnsureBlueprintIsUpToDate(Blueprint);
+		RefreshAffectedNodes(Blueprint, OldParent);
+	}
+	FBlueprintEditorUtils::MarkBlueprintAsModified(Blueprint);
+
+	if (Journal)
+	{
+		Journal->Record(Blueprint->GetOutermost()->GetFName(), ERetargetJournalState::Reparented, ParentClass ? ParentClass->GetPathName() : FString{});
+	}
+}
+
+bool FBlueprintRetargeter::ConfirmReparents(TArray<TPair<UBlueprint*, UClass*>>& Reparents) const
+{
+	TArray<UBlueprint*> Blueprints;
+	for (const auto& Reparent : Reparents)
+	{
+		Blueprints.Add(Reparent.Key);
+	}
+	SetActive(Blueprints);
+
+	const TArray<FRetargetCompatibilityReport> Reports = FRetargetCompatibility::Analyze(Reparents);
+
+	int32 NumIncompatible = 0;
+	for (const FRetargetCompatibilityReport& Report : Reports)
+	{
+		NumIncompatible += !Report.IsCompatible();
+	}
+	if (NumIncompatible <= 0)
+	{
+		return true;
+	}
+
+	const FString Description = FRetargetCompatibility::Describe(Reports);
+	if (bInteractive)
+	{
+		const FText Title = LOCTEXT("ReparentTitle", "Reparent Blueprint");
+		const FText Message = FText::Format(
+			LOCTEXT("ReparentWarning_Incompatible", "{0} of {1} blueprints use members the new parent doesn't have. These nodes will break:\n\n{2}\nContinue reparenting?"),
+			FText::AsNumber(NumIncompatible), FText::AsNumber(Reports.Num()), FText::FromString(Description));
+
+		FSuppressableWarningDialog::FSetupInfo Info(Message, Title, "Warning_ReparentTitle");
+		Info.ConfirmText = LOCTEXT("ReparentYesButton", "Reparent");
+		Info.CancelText = LOCTEXT("ReparentNoButton", "Cancel");
+		Info.CheckBoxText = FText::GetEmpty();	// not suppressible
+
+		return FSuppressableWarningDialog(Info).ShowModal() != FSuppressableWarningDialog::Cancel;
+	}
+
+	UE_LOG(LogBlueprintReparent, Warning, TEXT("%i of %i blueprints use members their new parent doesn't have:\n%s"), NumIncompatible, Reports.Num(), *Description);
+	if (bRejectIncompatible)
+	{
+		for (int32 Index = Reports.Num() - 1; Index >= 0; --Index)
+		{
+			if (!Reports[Index].IsCompatible())
+			{
+				Reparents.RemoveAt(Index);
+			}
+		}
+	}
+	return true;
+}
+
+bool FBlueprintRetargeter::Compile(UBlueprint* Blueprint)
+{
+	check(Blueprint);
+	RETARGET_PHASE_SCOPE(Compile, Blueprint);
+	INC_DWORD_STAT(STAT_BlueprintRetarget_NumCompiled);
+	SetActive({ Blueprint });
+
+	FCompilerResultsLog LogResults;
+	LogResults.SetSourcePath(Blueprint->GetPathName());
+	LogResults.BeginEvent(TEXT("Compile"));
+	FKismetEditorUtilities::CompileBlueprint(Blueprint, EBlueprintCompileOptions::None, &LogResults);
+
+	LogResults.EndEvent();
+	const bool bSucceeded = LogResults.NumErrors == 0;
+	RecordCompiled(Blueprint, bSucceeded);
+	return bSucceeded;
+}
+
+void FBlueprintRetargeter::CompileBlueprints(const TArray<UBlueprint*>& Blueprints)
+{
+	if (Blueprints.Num() <= 0)
+	{
+		return;
+	}
+
+	// A crash while compiling can come from any of them
+	SetActive(Blueprints);
+	{
+		// Queue all blueprints so that they get compiled and reinstanced in a single pass
+		RETARGET_PHASE_SCOPE(Compile, NAME_None);
+		for (UBlueprint* Blueprint : Blueprints)
+		{
+			FBlueprintCompilationManager::QueueForCompilation(Blueprint);
+		}
+		FBlueprintCompilationManager::FlushCompilationQueueAndReinstance();
+		INC_DWORD_STAT_BY(STAT_BlueprintRetarget_NumCompiled, Blueprints.Num());
+	}
+
+	for (const UBlueprint* Blueprint : Blueprints)
+	{
+		RecordCompiled(Blueprint, Blueprint->Status != BS_Error);
+	}
+
+	// Collect the garbage of all compilations at once
+	RETARGET_PHASE_SCOPE(GarbageCollect, NAME_None);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+void FBlueprintRetargeter::RecordCompiled(const UBlueprint* Blueprint, bool bSucceeded) const
+{
+	if (Journal)
+	{
+		Journal->Record(Blueprint->GetOutermost()->GetFName(),
+			bSucceeded ? ERetargetJournalState::Compiled : ERetargetJournalState::Failed,
+			bSucceeded ? FString{} : FString(TEXT("CompileFailed")));
+	}
+}
+
+void FBlueprintRetargeter::SetActive(const TArray<UBlueprint*>& Blueprints) const
+{
+	if (Journal)
+	{
+		TArray<FName> Packages;
+		for (const UBlueprint* Blueprint : Blueprints)
+		{
+			Packages.Add(Blueprint->GetOutermost()->GetFName());
+		}
+		Journal->SetActive(Packages);
+	}
+}
+
+void FBlueprintRetargeter::RefreshAffectedNodes(UBlueprint* Blueprint, const UClass* OldParent)
+{
+	RETARGET_PHASE_SCOPE(RefreshNodes, Blueprint);
+
+	if (CVarFullRefresh.GetValueOnGameThread())
+	{
+		FBlueprintEditorUtils::RefreshAllNodes(Blueprint);
+		return;
+	}
+
+	TArray<UK2Node*> AllNodes;
+	FBlueprintEditorUtils::GetAllNodesOfClass(Blueprint, AllNodes);
+
+	TSet<FName> OwnMembers;
+	FParentMemberUsage::GatherOwnMembers(Blueprint, OwnMembers);
+
+	TArray<UK2Node*> Nodes;
+	for (UK2Node* Node : AllNodes)
+	{
+		if (Node && IsAffectedByParent(Node, OldParent, OwnMembers))
+		{
+			Nodes.Add(Node);
+		}
+	}
+
+	// Nodes that change the blueprint's structure (events, function entries) go first, like on a full refresh
+	Algo::StableSortBy(Nodes, [](const UK2Node* Node) { return !Node->NodeCausesStructuralBlueprintChange(); });
+
+	// The rest resolve inherited members through the skeleton class. It must be regenerated against the new parent first
+	const bool bIsMacro = Blueprint->BlueprintType == BPTYPE_MacroLibrary;
+	bool bSkeletonUpToDate = false;
+	for (UK2Node* Node : Nodes)
+	{
+		if (!bSkeletonUpToDate && !Node->NodeCausesStructuralBlueprintChange())
+		{
+			if (!bIsMacro)
+			{
+				FKismetEditorUtilities::GenerateBlueprintSkeleton(Blueprint, true);
+			}
+			bSkeletonUpToDate = true;
+		}
+		Node->GetGraph()->GetSchema()->ReconstructNode(*Node, true);
+	}
+
+	UE_LOG(LogBlueprintReparent, Verbose, TEXT("Refreshed %i of %i nodes of %s"), Nodes.Num(), AllNodes.Num(), *Blueprint->GetName());
+}
+
+bool FBlueprintRetargeter::IsAffectedByParent(const UK2Node* Node, const UClass* OldParent, const TSet<FName>& OwnMembers)
+{
+	// A member is inherited if it is referenced on self without being declared by the blueprint,
+	// or if it was declared by the old parent (null when missing)
+	auto IsInherited = [&](const FMemberReference& Reference) {
+		if (Reference.IsSelfContext())
+		{
+			return !OwnMembers.Contains(Reference.GetMemberName());
+		}
+		const UClass* MemberParent = Reference.GetMemberParentClass();
+		return !MemberParent || (OldParent && OldParent->IsChildOf(MemberParent));
+	};
+
+	if (const UK2Node_Event* Event = Cast<UK2Node_Event>(Node))
+	{
+		return Event->bOverrideFunction && IsInherited(Event->EventReference);
+	}
+	if (const UK2Node_FunctionEntry* Entry = Cast<UK2Node_FunctionEntry>(Node))
+	{
+		return !Entry->FunctionReference.IsSelfContext();
+	}
+	if (Node->IsA<UK2Node_CallParentFunction>() || Node->IsA<UK2Node_Self>() || Node->IsA<UK2Node_ComponentBoundEvent>())
+	{
+		return true;
+	}
+	if (const UK2Node_CallFunction* Call = Cast<UK2Node_CallFunction>(Node))
+	{
+		if (IsInherited(Call->FunctionReference))
+		{
+			return true;
+		}
+	}
+	else if (const UK2Node_Variable* Variable = Cast<UK2Node_Variable>(Node))
+	{
+		if (IsInherited(Variable->VariableReference))
+		{
+			return true;
+		}
+	}
+
+	// Any other node typed to the old parent (E.g: casts)
+	for (const UEdGraphPin* Pin : Node->Pins)
+	{
+		const UObject* PinClass = Pin ? Pin->PinType.PinSubCategoryObject.Get() : nullptr;
+		if (PinClass && PinClass == OldParent)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FBlueprintRetargeter::NeedsUpdateAfterCompile(const UBlueprint* Blueprint, const FInheritedLayout* OldParentLayout)
+{
+	// Scene root, events, interfaces and parent calls are conformed to the new parent once it is in place
+	if (!OldParentLayout || !OldParentLayout->Matches(FInheritedLayout(Blueprint->ParentClass)))
+	{
+		return true;
+	}
+
+	// The construction script can only be created once the blueprint has a generated class,
+	// which broken blueprints don't have until they compile
+	if (FBlueprintEditorUtils::SupportsConstructionScript(Blueprint))
+	{
+		return !Blueprint->SimpleConstructionScript || !FBlueprintEditorUtils::FindUserConstructionScript(Blueprint);
+	}
+	return Blueprint->SimpleConstructionScript != nullptr;
+}
+
+void FBlueprintRetargeter::EnsureBlueprintIsUpToDate(UBlueprint* Blueprint)
+{
+	RETARGET_PHASE_SCOPE(Ensure, Blueprint);
+
+	// Purge any nullptr graphs
+	FBlueprintEditorUtils::PurgeNullGraphs(Blueprint);
+
+	// Make sure the blueprint is cosmetically up to date
+	FKismetEditorUtilities::UpgradeCosmeticallyStaleBlueprint(Blueprint);
+
+	if (FBlueprintEditorUtils::SupportsConstructionScript(Blueprint))
+	{
+		// If we don't have an SCS yet, make it
+		if (Blueprint->GeneratedClass && !Blueprint->SimpleConstructionScript)
+		{
+			Blueprint->SimpleConstructionScript = NewObject<USimpleConstructionScript>(Blueprint->GeneratedClass);
+			Blueprint->SimpleConstructionScript->SetFlags(RF_Transactional);
+		}
+
+		// If we should have a UCS but don't yet, make it
+		if (!FBlueprintEditorUtils::FindUserConstructionScript(Blueprint))
+		{
+			UEdGraph* UCSGraph = FBlueprintEditorUtils::CreateNewGraph(Blueprint, UEdGraphSchema_K2::FN_UserConstructionScript, UEdGraph::StaticClass(), UEdGraphSchema_K2::StaticClass());
+			FBlueprintEditorUtils::AddFunctionGraph(Blueprint, UCSGraph, /*bIsUserCreated=*/ false, AActor::StaticClass());
+			UCSGraph->bAllowDeletion = false;
+		}
+
+		// Check to see if we have gained a component from our parent (that would require us removing our scene root)
+		// (or lost one, which requires adding one)
+		if (Blueprint->SimpleConstructionScript != nullptr)
+		{
+			Blueprint->SimpleConstructionScript->ValidateSceneRootNodes();
+		}
+	}
+	else
+	{
+		// If we have an SCS but don't support it, then we remove it
+		if (Blueprint->SimpleConstructionScript)
+		{
+			// Remove any SCS variable nodes
+			for (USCS_Node* SCS_Node : Blueprint->SimpleConstructionScript->GetAllNodes())
+			{
+				if (SCS_Node)
+				{
+					FBlueprintEditorUtils::RemoveVariableNodes(Blueprint, SCS_Node->GetVariableName());
+				}
+			}
+
+			// Remove the SCS object reference
+			Blueprint->SimpleConstructionScript = nullptr;
+
+			// Mark the Blueprint as having been structurally modified
+			FBlueprintEditorUtils::MarkBlueprintAsStructurallyModified(Blueprint);
+		}
+	}
+
+	// Make sure that this blueprint is up-to-date with regards to its parent functions
+	FBlueprintEditorUtils::ConformCallsToParentFunctions(Blueprint);
+
+	// Make sure that this blueprint is up-to-date with regards to its implemented events
+	FBlueprintEditorUtils::ConformImplementedEvents(Blueprint);
+
+	// Make sure that this blueprint is up-to-date with regards to its implemented interfaces
+	FBlueprintEditorUtils::ConformImplementedInterfaces(Blueprint);
+
+	// Update old composite nodes(can't do this in PostLoad)
+	FBlueprintEditorUtils::UpdateOutOfDateCompositeNodes(Blueprint);
+
+	// Update any nodes which might have dropped their RF_Transactional flag due to copy-n-paste issues
+	FBlueprintEditorUtils::UpdateTransactionalFlags(Blueprint);
+}
+
+
+FRetargetHierarchyTask::FRetargetHierarchyTask(FBlueprintRetargeter& InRetargeter, FRetargetHierarchy& InHierarchy)
+	: Retargeter(InRetargeter)
+	, Hierarchy(InHierarchy)
+{}
+
+bool FRetargetHierarchyTask::Step()
+{
+	switch (CurrentStep)
+	{
+	case EStep::Confirm:
+	{
+		UE_LOG(LogBlueprintReparent, Log, TEXT("Retargeting %i blueprints in %i independent batches"), Hierarchy.Nodes.Num(), Hierarchy.Batches.Num());
+		for (const TArray<int32>& Batch : Hierarchy.Batches)
+		{
+			UE_LOG(LogBlueprintReparent, Log, TEXT("  %s and %i children"), *Hierarchy.Nodes[Batch[0]].AssetData.ObjectPath.ToString(), Batch.Num() - 1);
+		}
+
+		// Roots are analyzed before touching anything. Children keep their parent. Roots without a new parent are skipped
+		TArray<TPair<UBlueprint*, UClass*>> Reparents;
+		for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
+		{
+			if (Node.Blueprint && Node.Parent == INDEX_NONE && Node.NewParent)
+			{
+				Reparents.Emplace(Node.Blueprint, Node.NewParent);
+			}
+		}
+
+		if (bCancelled || !Retargeter.ConfirmReparents(Reparents))
+		{
+			CurrentStep = EStep::Finished;
+			return false;
+		}
+
+		for (const auto& Reparent : Reparents)
+		{
+			AcceptedRoots.Add(Reparent.Key);
+		}
+		for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
+		{
+			if (Node.Blueprint && Node.Parent == INDEX_NONE && Node.NewParent && !AcceptedRoots.Contains(Node.Blueprint))
+			{
+				Rejected.Add(Node.Blueprint);
+			}
+		}
+		Depth = 0;
+		CurrentStep = EStep::Begin;
+		return true;
+	}
+
+	case EStep::Begin:
+		// Reparent one blueprint of this level at a time. Order is sorted by depth
+		if (!bCancelled && OrderIndex < Hierarchy.Order.Num() && Hierarchy.Nodes[Hierarchy.Order[OrderIndex]].Depth == Depth)
+		{
+			const int32 NodeIndex = Hierarchy.Order[OrderIndex++];
+			FRetargetHierarchy::FNode& Node = Hierarchy.Nodes[NodeIndex];
+			if (!Node.Blueprint)
+			{
+				return true;
+			}
+
+			if (Node.Parent == INDEX_NONE)
+			{
+				if (AcceptedRoots.Contains(Node.Blueprint) && Retargeter.BeginReparent(Node.Blueprint, Node.NewParent))
+				{
+					Level.Add(Node.Blueprint);
+					RetargetedNodes.Add(NodeIndex);
+				}
+				else if (Node.Blueprint->ParentClass && (!Node.NewParent || Node.NewParent == Node.Blueprint->ParentClass) && !FRetargetUtils::IsInvalidBlueprint(Node.Blueprint))
+				{
+					// Its parent got fixed before (E.g: by a previous chunk or run). It only needs to be recompiled, like a child
+					Retargeter.RestoreParent(Node.Blueprint, Node.Blueprint->ParentClass);
+					Level.Add(Node.Blueprint);
+					RetargetedNodes.Add(NodeIndex);
+				}
+			}
+			else if (RetargetedNodes.Contains(Node.Parent))
+			{
+				// Parent was fixed, the child only needs to point to it again
+				Retargeter.RestoreParent(Node.Blueprint, Hierarchy.Nodes[Node.Parent].Blueprint->GeneratedClass);
+				Level.Add(Node.Blueprint);
+				RetargetedNodes.Add(NodeIndex);
+			}
+			return true;
+		}
+		CurrentStep = EStep::Compile;
+		return true;
+
+	case EStep::Compile:
+		// Blueprints of the level are compiled together, even if reparenting them was spread over several steps
+		Retargeter.CompileBlueprints(Level);
+		LevelIndex = 0;
+		CurrentStep = EStep::End;
+		return true;
+
+	case EStep::End:
+		if (LevelIndex < Level.Num())
+		{
+			Retargeter.EndReparent(Level[LevelIndex++]);
+			return true;
+		}
+
+		Retargeted.Append(Level);
+		Level.Reset();
+		if (bCancelled || OrderIndex >= Hierarchy.Order.Num())
+		{
+			if (Retargeter.bInteractive && FSlateApplication::IsInitialized())
+			{
+				FSlateApplication::Get().DismissAllMenus();
+			}
+			CurrentStep = EStep::Finished;
+			return false;
+		}
+
+		Depth = Hierarchy.Nodes[Hierarchy.Order[OrderIndex]].Depth;
+		CurrentStep = EStep::Begin;
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
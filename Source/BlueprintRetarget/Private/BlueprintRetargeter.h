@@ -0,0 +1,177 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+class UBlueprint;
+class UClass;
+class UK2Node;
+struct FRetargetHierarchy;
+class FRetargetJournal;
+
+
+/** What a parent class gives to its blueprints, that EnsureBlueprintIsUpToDate conforms them to */
+struct FInheritedLayout
+{
+	/** False if there was no class. Never matches */
+	bool bValid = false;
+	FName RootComponent;
+	FName RootComponentClass;
+	TSet<FName> Interfaces;
+	TSet<FName> OverridableFunctions;
+
+
+	FInheritedLayout() {}
+	explicit FInheritedLayout(const UClass* Class);
+
+	bool Matches(const FInheritedLayout& Other) const;
+};
+
+
+/** Reparents blueprints and brings them up to date with their new parent class */
+class FBlueprintRetargeter
+{
+public:
+	/** If false, no dialog will be shown and every reparent will be accepted */
+	bool bInteractive;
+
+	/** If true, blueprints predicted to break with their new parent are not reparented when not interactive */
+	bool bRejectIncompatible = false;
+
+	/** If set, blueprints are recorded on it before and after each step */
+	FRetargetJournal* Journal = nullptr;
+
+
+	FBlueprintRetargeter(bool bInInteractive = true)
+		: bInteractive(bInInteractive)
+	{}
+
+	/** @return true if the blueprint was reparented */
+	bool ReparentBlueprint(UBlueprint* Blueprint, UClass* ChosenClass);
+
+	/**
+	 * Reparents all blueprints first and then compiles them together in a single pass.
+	 * @return blueprints that were reparented
+	 */
+	TArray<UBlueprint*> ReparentBlueprints(const TArray<UBlueprint*>& Blueprints, UClass* ChosenClass);
+
+	/**
+	 * Retargets root blueprints of the hierarchy to their NewParent and restores the parent of their children.
+	 * Roots whose parent is valid already (E.g: fixed by a previous run) are only recompiled.
+	 * Blueprints are compiled exactly once, one pass per depth level, parents first.
+	 * @return blueprints that were reparented or recompiled
+	 */
+	TArray<UBlueprint*> ReparentHierarchy(FRetargetHierarchy& Hierarchy);
+
+	/**
+	 * Predicts which nodes would break with the new parents before modifying anything, and reports it once for all blueprints.
+	 * Rejected blueprints are removed from the list.
+	 * @return false if the user canceled the retarget
+	 */
+	bool ConfirmReparents(TArray<TPair<UBlueprint*, UClass*>>& Reparents) const;
+
+	/**
+	 * Assigns the new parent and refreshes the blueprint, without compiling it.
+	 * Doesn't ask for confirmation, see ConfirmReparents.
+	 * Must be followed by a compile and EndReparent.
+	 * @return true if the blueprint was reparented
+	 */
+	bool BeginReparent(UBlueprint* Blueprint, UClass* ChosenClass);
+
+	/** Brings a reparented blueprint up to date after it got compiled */
+	void EndReparent(UBlueprint* Blueprint);
+
+	/** @return true if the blueprint compiled without errors */
+	bool Compile(UBlueprint* Blueprint);
+
+	/**
+	 * Compiles all blueprints in a single pass of the compilation manager.
+	 * Reinstancing and garbage collection only happen once.
+	 */
+	void CompileBlueprints(const TArray<UBlueprint*>& Blueprints);
+
+	static void EnsureBlueprintIsUpToDate(UBlueprint* Blueprint);
+
+	/** Points a child blueprint back to its parent blueprint class once the parent got fixed */
+	void RestoreParent(UBlueprint* Blueprint, UClass* ParentClass);
+
+private:
+
+	/**
+	 * Layout of the parent each blueprint had before BeginReparent. Blueprints without one always get updated after compiling.
+	 * Parents restored by RestoreParent are not included, since they change in place when retargeted.
+	 */
+	TMap<const UBlueprint*, FInheritedLayout> OldParentLayouts;
+
+
+	/** Reconstructs only nodes that can change with the parent. All of them if BlueprintRetarget.FullRefresh is set */
+	static void RefreshAffectedNodes(UBlueprint* Blueprint, const UClass* OldParent);
+
+	static bool IsAffectedByParent(const UK2Node* Node, const UClass* OldParent, const TSet<FName>& OwnMembers);
+
+	void SetActive(const TArray<UBlueprint*>& Blueprints) const;
+
+	/** Records the blueprint as compiled, or as failed if it had errors. Only compile functions know it */
+	void RecordCompiled(const UBlueprint* Blueprint, bool bSucceeded) const;
+
+	/**
+	 * @return true if compiling left something EnsureBlueprintIsUpToDate has to fix: a missing construction script,
+	 * or a new parent whose root component, interfaces or overridable functions differ from the old one
+	 */
+	static bool NeedsUpdateAfterCompile(const UBlueprint* Blueprint, const FInheritedLayout* OldParentLayout);
+};
+
+
+/**
+ * Retargets a hierarchy one blueprint at a time, so that the work can be spread over several frames.
+ * Blueprints of the same depth level are still compiled together, parents first. See FBlueprintRetargeter::ReparentHierarchy
+ */
+class FRetargetHierarchyTask
+{
+	enum class EStep : uint8
+	{
+		Confirm,
+		Begin,
+		Compile,
+		End,
+		Finished
+	};
+
+	FBlueprintRetargeter& Retargeter;
+	FRetargetHierarchy& Hierarchy;
+
+	EStep CurrentStep = EStep::Confirm;
+	bool bCancelled = false;
+
+	TSet<UBlueprint*> AcceptedRoots;
+	TSet<int32> RetargetedNodes;
+	int32 OrderIndex = 0;
+	int32 Depth = 0;
+
+	/** Blueprints of the current depth level */
+	TArray<UBlueprint*> Level;
+	int32 LevelIndex = 0;
+
+	TArray<UBlueprint*> Retargeted;
+	TArray<UBlueprint*> Rejected;
+
+
+public:
+	FRetargetHierarchyTask(FBlueprintRetargeter& InRetargeter, FRetargetHierarchy& InHierarchy);
+
+	/** Does the next unit of work. @return false once finished */
+	bool Step();
+
+	/** Stops once blueprints already reparented got compiled, so none is left half retargeted */
+	void Cancel() { bCancelled = true; }
+
+	/** @return number of blueprints of the hierarchy already visited */
+	int32 GetNumProcessed() const { return OrderIndex; }
+
+	/** Blueprints reparented or recompiled so far */
+	const TArray<UBlueprint*>& GetRetargeted() const { return Retargeted; }
+
+	/** Roots not reparented because they would break with their new parent. See FBlueprintRetargeter::bRejectIncompatible */
+	const TArray<UBlueprint*>& GetRejected() const { return Rejected; }
+};
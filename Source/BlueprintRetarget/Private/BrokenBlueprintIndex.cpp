@@ -0,0 +1,491 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "BrokenBlueprintIndex.h"
+#include "BlueprintRetarget.h"
+#include "RetargetUtils.h"
+
+#include <AssetRegistryModule.h>
+#include <Engine/Blueprint.h>
+#include <Misc/FileHelper.h>
+#include <Misc/PackageName.h>
+#include <Misc/Paths.h>
+#include <Dom/JsonObject.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonWriter.h>
+#include <Serialization/JsonSerializer.h>
+#include <UObject/UObjectGlobals.h>
+
+
+FBrokenBlueprintIndex& FBrokenBlueprintIndex::Get()
+{
+	static FBrokenBlueprintIndex Instance;
+	return Instance;
+}
+
+void FBrokenBlueprintIndex::Initialize()
+{
+	if (bInitialized)
+	{
+		return;
+	}
+	bInitialized = true;
+
+	// Previous session entries are available instantly and confirmed as the registry finds them
+	LoadCache();
+
+	// Blueprint parents can only be checked once the registry finished loading, see OnFilesLoaded
+	CheckCachedParents(false);
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.OnAssetAdded().AddRaw(this, &FBrokenBlueprintIndex::OnAssetAdded);
+	AssetRegistry.OnAssetRemoved().AddRaw(this, &FBrokenBlueprintIndex::OnAssetRemoved);
+	AssetRegistry.OnAssetRenamed().AddRaw(this, &FBrokenBlueprintIndex::OnAssetRenamed);
+	FModuleManager::Get().OnModulesChanged().AddRaw(this, &FBrokenBlueprintIndex::OnModulesChanged);
+	FCoreUObjectDelegates::OnObjectSaved.AddRaw(this, &FBrokenBlueprintIndex::OnObjectSaved);
+
+	// Blueprints discovered before we started listening. Only those that changed since the last session are evaluated
+	TArray<FAssetData> Blueprints;
+	AssetRegistry.GetAssetsByClass(UBlueprint::StaticClass()->GetFName(), Blueprints, true);
+	for (const FAssetData& AssetData : Blueprints)
+	{
+		if (!RestoreCached(AssetData))
+		{
+			Evaluate(AssetData);
+		}
+	}
+
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		AssetRegistry.OnFilesLoaded().AddRaw(this, &FBrokenBlueprintIndex::OnFilesLoaded);
+	}
+	else
+	{
+		OnFilesLoaded();
+	}
+}
+
+void FBrokenBlueprintIndex::Shutdown()
+{
+	if (!bInitialized)
+	{
+		return;
+	}
+	bInitialized = false;
+
+	if (FAssetRegistryModule* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>(TEXT("AssetRegistry")))
+	{
+		IAssetRegistry& AssetRegistry = AssetRegistryModule->Get();
+		AssetRegistry.OnAssetAdded().RemoveAll(this);
+		AssetRegistry.OnAssetRemoved().RemoveAll(this);
+		AssetRegistry.OnAssetRenamed().RemoveAll(this);
+		AssetRegistry.OnFilesLoaded().RemoveAll(this);
+	}
+	FModuleManager::Get().OnModulesChanged().RemoveAll(this);
+	FCoreUObjectDelegates::OnObjectSaved.RemoveAll(this);
+
+	if (bDirty)
+	{
+		SaveCache();
+	}
+
+	Entries.Empty();
+	BlueprintsByParentPackage.Empty();
+	ParentPackagesByBlueprint.Empty();
+	ParentTags.Empty();
+	ResolvedParents.Empty();
+	StaleParents.Empty();
+	UnverifiedEntries.Empty();
+}
+
+bool FBrokenBlueprintIndex::IsBroken(const FAssetData& AssetData) const
+{
+	// Loaded blueprints may have been fixed in memory
+	if (AssetData.IsAssetLoaded())
+	{
+		return FRetargetUtils::IsInvalidBlueprint(AssetData);
+	}
+
+	if (ParentPackagesByBlueprint.Contains(AssetData.ObjectPath))
+	{
+		return Entries.Contains(AssetData.ObjectPath);
+	}
+
+	// Not indexed yet
+	return FRetargetUtils::IsInvalidBlueprint(AssetData);
+}
+
+void FBrokenBlueprintIndex::Refresh(const FAssetData& AssetData)
+{
+	Evaluate(AssetData);
+}
+
+/** @return parent tags of a blueprint, separated by '|'. Its state only depends on them and on its parents existing */
+static FString GetParentTags(const FAssetData& AssetData)
+{
+	FString ParentPath;
+	FString NativeParentPath;
+	AssetData.GetTagValue(FBlueprintTags::ParentClassPath, ParentPath);
+	AssetData.GetTagValue(FBlueprintTags::NativeParentClassPath, NativeParentPath);
+	return ParentPath + TEXT("|") + NativeParentPath;
+}
+
+void FBrokenBlueprintIndex::Evaluate(const FAssetData& AssetData)
+{
+	if (!FRetargetUtils::IsBlueprintAsset(AssetData))
+	{
+		return;
+	}
+
+	UnverifiedEntries.Remove(AssetData.ObjectPath);
+	TrackParents(AssetData);
+
+	FString Tags = GetParentTags(AssetData);
+	FString& CachedTags = ParentTags.FindOrAdd(AssetData.ObjectPath);
+	if (CachedTags != Tags)
+	{
+		CachedTags = MoveTemp(Tags);
+		bDirty = true;
+	}
+
+	FString UnresolvedParent;
+	if (AssetData.IsAssetLoaded())
+	{
+		if (FRetargetUtils::IsInvalidBlueprint(AssetData))
+		{
+			UnresolvedParent = FRetargetUtils::GetParentClassPath(AssetData);
+			if (UnresolvedParent.IsEmpty())
+			{
+				UnresolvedParent = TEXT("None");
+			}
+		}
+	}
+	else
+	{
+		UnresolvedParent = FRetargetUtils::FindUnresolvedParentPath(AssetData);
+	}
+
+	if (UnresolvedParent.IsEmpty())
+	{
+		RemoveEntry(AssetData.ObjectPath);
+	}
+	else
+	{
+		AddEntry(AssetData.ObjectPath, UnresolvedParent);
+	}
+}
+
+bool FBrokenBlueprintIndex::RestoreCached(const FAssetData& AssetData)
+{
+	// Loaded blueprints may have changed in memory
+	const FString* CachedTags = ParentTags.Find(AssetData.ObjectPath);
+	if (!CachedTags || AssetData.IsAssetLoaded() || !UnverifiedEntries.Contains(AssetData.ObjectPath) ||
+		!FRetargetUtils::IsBlueprintAsset(AssetData) || *CachedTags != GetParentTags(AssetData))
+	{
+		return false;
+	}
+
+	TArray<FString> Parents;
+	CachedTags->ParseIntoArray(Parents, TEXT("|"));
+	for (const FString& Parent : Parents)
+	{
+		if (!ResolvedParents.Contains(Parent) || StaleParents.Contains(Parent))
+		{
+			return false;
+		}
+	}
+
+	// Its entry, if broken, was already loaded from the cache
+	UnverifiedEntries.Remove(AssetData.ObjectPath);
+	TrackParents(AssetData);
+	return true;
+}
+
+void FBrokenBlueprintIndex::CheckCachedParents(bool bBlueprintParents)
+{
+	for (auto& Parent : ResolvedParents)
+	{
+		const FString ParentPath = FPackageName::ExportTextPathToObjectPath(Parent.Key);
+		if (FPackageName::IsScriptPackage(ParentPath) == bBlueprintParents)
+		{
+			continue;
+		}
+
+		const bool bResolved = FRetargetUtils::IsClassPathResolved(Parent.Key);
+		if (bResolved != Parent.Value)
+		{
+			Parent.Value = bResolved;
+			StaleParents.Add(Parent.Key);
+			RefreshDependents(FName(*FPackageName::ObjectPathToPackageName(ParentPath)));
+		}
+	}
+}
+
+void FBrokenBlueprintIndex::AddEntry(FName ObjectPath, const FString& ParentPath)
+{
+	FString& Entry = Entries.FindOrAdd(ObjectPath);
+	if (Entry != ParentPath)
+	{
+		Entry = ParentPath;
+		bDirty = true;
+		OnChanged.Broadcast();
+	}
+}
+
+void FBrokenBlueprintIndex::RemoveEntry(FName ObjectPath)
+{
+	if (Entries.Remove(ObjectPath) > 0)
+	{
+		bDirty = true;
+		OnChanged.Broadcast();
+	}
+}
+
+void FBrokenBlueprintIndex::TrackParents(const FAssetData& AssetData)
+{
+	UntrackParents(AssetData.ObjectPath);
+
+	auto& ParentPackages = ParentPackagesByBlueprint.Add(AssetData.ObjectPath);
+	for (const FName& Tag : { FBlueprintTags::ParentClassPath, FBlueprintTags::NativeParentClassPath })
+	{
+		FString ParentPath;
+		if (AssetData.GetTagValue(Tag, ParentPath) && ParentPath != TEXT("None"))
+		{
+			const FName ParentPackage{ *FPackageName::ObjectPathToPackageName(FPackageName::ExportTextPathToObjectPath(ParentPath)) };
+			ParentPackages.AddUnique(ParentPackage);
+			BlueprintsByParentPackage.FindOrAdd(ParentPackage).Add(AssetData.ObjectPath);
+		}
+	}
+}
+
+void FBrokenBlueprintIndex::UntrackParents(FName ObjectPath)
+{
+	TArray<FName, TInlineAllocator<2>> ParentPackages;
+	if (ParentPackagesByBlueprint.RemoveAndCopyValue(ObjectPath, ParentPackages))
+	{
+		for (const FName& ParentPackage : ParentPackages)
+		{
+			if (TSet<FName>* Dependents = BlueprintsByParentPackage.Find(ParentPackage))
+			{
+				Dependents->Remove(ObjectPath);
+				if (Dependents->Num() <= 0)
+				{
+					BlueprintsByParentPackage.Remove(ParentPackage);
+				}
+			}
+		}
+	}
+}
+
+void FBrokenBlueprintIndex::RefreshDependents(FName ParentPackage)
+{
+	const TSet<FName>* Dependents = BlueprintsByParentPackage.Find(ParentPackage);
+	if (!Dependents)
+	{
+		return;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	const TArray<FName> DependentPaths = Dependents->Array();
+	for (const FName& ObjectPath : DependentPaths)
+	{
+		const FAssetData AssetData = AssetRegistry.GetAssetByObjectPath(ObjectPath);
+		if (AssetData.IsValid())
+		{
+			Evaluate(AssetData);
+		}
+	}
+}
+
+void FBrokenBlueprintIndex::BreakDependents(FName ParentPackage)
+{
+	const TSet<FName>* Dependents = BlueprintsByParentPackage.Find(ParentPackage);
+	if (!Dependents)
+	{
+		return;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	const FString ParentPackageName = ParentPackage.ToString();
+	for (const FName& ObjectPath : *Dependents)
+	{
+		// The parent may still be in memory while it gets removed, so use the path that depends on it
+		const FAssetData AssetData = AssetRegistry.GetAssetByObjectPath(ObjectPath);
+		FString ParentPath = FRetargetUtils::GetParentClassPath(AssetData);
+		if (FPackageName::ObjectPathToPackageName(ParentPath) != ParentPackageName)
+		{
+			FString NativeParentPath;
+			AssetData.GetTagValue(FBlueprintTags::NativeParentClassPath, NativeParentPath);
+			ParentPath = FPackageName::ExportTextPathToObjectPath(NativeParentPath);
+		}
+		AddEntry(ObjectPath, ParentPath);
+	}
+}
+
+void FBrokenBlueprintIndex::OnAssetAdded(const FAssetData& AssetData)
+{
+	// Existed in the last session without changes. The state of its children didn't change either
+	if (RestoreCached(AssetData))
+	{
+		return;
+	}
+
+	Evaluate(AssetData);
+
+	// A parent that appeared can fix its children
+	RefreshDependents(AssetData.PackageName);
+}
+
+void FBrokenBlueprintIndex::OnAssetRemoved(const FAssetData& AssetData)
+{
+	UnverifiedEntries.Remove(AssetData.ObjectPath);
+	UntrackParents(AssetData.ObjectPath);
+	RemoveEntry(AssetData.ObjectPath);
+	bDirty |= ParentTags.Remove(AssetData.ObjectPath) > 0;
+
+	BreakDependents(AssetData.PackageName);
+}
+
+void FBrokenBlueprintIndex::OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath)
+{
+	const FName OldPath{ *OldObjectPath };
+	UnverifiedEntries.Remove(OldPath);
+	UntrackParents(OldPath);
+	RemoveEntry(OldPath);
+	bDirty |= ParentTags.Remove(OldPath) > 0;
+
+	Evaluate(AssetData);
+
+	// Children still point to the old path. They are fine only if a redirector was left behind
+	RefreshDependents(FName(*FPackageName::ObjectPathToPackageName(OldObjectPath)));
+}
+
+void FBrokenBlueprintIndex::OnFilesLoaded()
+{
+	// Cached entries the registry didn't find anymore don't exist
+	for (const FName& ObjectPath : UnverifiedEntries)
+	{
+		RemoveEntry(ObjectPath);
+		bDirty |= ParentTags.Remove(ObjectPath) > 0;
+	}
+	UnverifiedEntries.Empty();
+
+	// Blueprint parents that appeared or disappeared since the last session, now that the registry knows them all
+	CheckCachedParents(true);
+	StaleParents.Empty();
+
+	if (bDirty)
+	{
+		SaveCache();
+	}
+}
+
+void FBrokenBlueprintIndex::OnModulesChanged(FName ModuleName, EModuleChangeReason Reason)
+{
+	const FName ScriptPackage{ *(TEXT("/Script/") + ModuleName.ToString()) };
+	if (Reason == EModuleChangeReason::ModuleLoaded)
+	{
+		RefreshDependents(ScriptPackage);
+	}
+	else if (Reason == EModuleChangeReason::ModuleUnloaded)
+	{
+		BreakDependents(ScriptPackage);
+	}
+}
+
+void FBrokenBlueprintIndex::OnObjectSaved(UObject* Object)
+{
+	if (UBlueprint* Blueprint = Cast<UBlueprint>(Object))
+	{
+		Evaluate(FAssetData(Blueprint));
+	}
+}
+
+FString FBrokenBlueprintIndex::GetCacheFilename() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("BlueprintRetarget") / TEXT("BrokenBlueprints.json");
+}
+
+void FBrokenBlueprintIndex::LoadCache()
+{
+	FString CacheText;
+	if (!FFileHelper::LoadFileToString(CacheText, *GetCacheFilename()))
+	{
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Cache;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(CacheText);
+	if (!FJsonSerializer::Deserialize(Reader, Cache) || !Cache.IsValid())
+	{
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("Ignored invalid broken blueprints cache '%s'"), *GetCacheFilename());
+		return;
+	}
+
+	const TSharedPtr<FJsonObject>* CachedEntries;
+	if (Cache->TryGetObjectField(TEXT("Blueprints"), CachedEntries))
+	{
+		for (const auto& Entry : (*CachedEntries)->Values)
+		{
+			const FName ObjectPath{ *Entry.Key };
+			Entries.Add(ObjectPath, Entry.Value->AsString());
+			UnverifiedEntries.Add(ObjectPath);
+		}
+	}
+
+	// Tags and parents of every blueprint, broken or not, so that unchanged ones don't need to be evaluated again
+	const TSharedPtr<FJsonObject>* CachedTags;
+	const TSharedPtr<FJsonObject>* CachedParents;
+	if (Cache->TryGetObjectField(TEXT("Tags"), CachedTags) && Cache->TryGetObjectField(TEXT("Parents"), CachedParents))
+	{
+		for (const auto& Entry : (*CachedTags)->Values)
+		{
+			const FName ObjectPath{ *Entry.Key };
+			ParentTags.Add(ObjectPath, Entry.Value->AsString());
+			UnverifiedEntries.Add(ObjectPath);
+		}
+		for (const auto& Entry : (*CachedParents)->Values)
+		{
+			ResolvedParents.Add(Entry.Key, Entry.Value->AsBool());
+		}
+	}
+}
+
+void FBrokenBlueprintIndex::SaveCache()
+{
+	TSharedRef<FJsonObject> CachedEntries = MakeShared<FJsonObject>();
+	for (const auto& Entry : Entries)
+	{
+		CachedEntries->SetStringField(Entry.Key.ToString(), Entry.Value);
+	}
+
+	// Parents are checked once each. Children of the same parent share its state
+	TSharedRef<FJsonObject> CachedTags = MakeShared<FJsonObject>();
+	TSharedRef<FJsonObject> CachedParents = MakeShared<FJsonObject>();
+	TArray<FString> Parents;
+	for (const auto& Entry : ParentTags)
+	{
+		CachedTags->SetStringField(Entry.Key.ToString(), Entry.Value);
+
+		Entry.Value.ParseIntoArray(Parents, TEXT("|"));
+		for (const FString& Parent : Parents)
+		{
+			if (!CachedParents->HasField(Parent))
+			{
+				CachedParents->SetBoolField(Parent, FRetargetUtils::IsClassPathResolved(Parent));
+			}
+		}
+	}
+
+	TSharedRef<FJsonObject> Cache = MakeShared<FJsonObject>();
+	Cache->SetObjectField(TEXT("Blueprints"), CachedEntries);
+	Cache->SetObjectField(TEXT("Tags"), CachedTags);
+	Cache->SetObjectField(TEXT("Parents"), CachedParents);
+
+	FString CacheText;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&CacheText);
+	FJsonSerializer::Serialize(Cache, Writer);
+	if (FFileHelper::SaveStringToFile(CacheText, *GetCacheFilename()))
+	{
+		bDirty = false;
+	}
+}
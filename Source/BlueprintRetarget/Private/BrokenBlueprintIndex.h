@@ -0,0 +1,95 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Modules/ModuleManager.h>
+
+struct FAssetData;
+
+
+/**
+ * Project-wide index of blueprints whose parent can't be resolved.
+ * Built from asset registry tags, kept up to date incrementally and cached between sessions under Saved/.
+ */
+class FBrokenBlueprintIndex
+{
+public:
+	/** Called every time an entry is added or removed */
+	FSimpleMulticastDelegate OnChanged;
+
+private:
+	/** Blueprint object path -> Unresolved parent class path */
+	TMap<FName, FString> Entries;
+
+	/** Parent package (native module or blueprint) -> Blueprints depending on it */
+	TMap<FName, TSet<FName>> BlueprintsByParentPackage;
+
+	/** Blueprint object path -> Packages it was registered at BlueprintsByParentPackage */
+	TMap<FName, TArray<FName, TInlineAllocator<2>>> ParentPackagesByBlueprint;
+
+	/** Blueprint object path -> Parent tags it had when it was last evaluated */
+	TMap<FName, FString> ParentTags;
+
+	/** Parent class path -> If it was resolved when the cache was written. Updated once checked again */
+	TMap<FString, bool> ResolvedParents;
+
+	/** Cached parents whose state changed since the cache was written. Their children can't be restored from it */
+	TSet<FString> StaleParents;
+
+	/** Cached blueprints that the asset registry didn't confirm yet */
+	TSet<FName> UnverifiedEntries;
+
+	bool bInitialized = false;
+	bool bDirty = false;
+
+
+public:
+	static FBrokenBlueprintIndex& Get();
+
+	void Initialize();
+	void Shutdown();
+
+	bool IsBroken(const FAssetData& AssetData) const;
+	bool IsBroken(FName ObjectPath) const { return Entries.Contains(ObjectPath); }
+
+	/** @return the unresolved parent class path of a blueprint, or nullptr if its not broken */
+	const FString* FindUnresolvedParent(FName ObjectPath) const { return Entries.Find(ObjectPath); }
+
+	const TMap<FName, FString>& GetEntries() const { return Entries; }
+
+	/** Evaluates a blueprint again. E.g: After it was retargeted */
+	void Refresh(const FAssetData& AssetData);
+
+	/** Re-evaluates every blueprint that depends on a parent package. E.g: After it got redirected */
+	void RefreshDependents(FName ParentPackage);
+
+private:
+	void Evaluate(const FAssetData& AssetData);
+
+	/** Takes the state of a blueprint from the cache if neither its tags nor its parents changed. @return true if restored */
+	bool RestoreCached(const FAssetData& AssetData);
+
+	/** Checks again cached parents, native or blueprint ones, and refreshes the children of those that changed */
+	void CheckCachedParents(bool bBlueprintParents);
+
+	void AddEntry(FName ObjectPath, const FString& ParentPath);
+	void RemoveEntry(FName ObjectPath);
+
+	void TrackParents(const FAssetData& AssetData);
+	void UntrackParents(FName ObjectPath);
+
+	/** Marks as broken every blueprint that depends on a parent package */
+	void BreakDependents(FName ParentPackage);
+
+	void OnAssetAdded(const FAssetData& AssetData);
+	void OnAssetRemoved(const FAssetData& AssetData);
+	void OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath);
+	void OnFilesLoaded();
+	void OnModulesChanged(FName ModuleName, EModuleChangeReason Reason);
+	void OnObjectSaved(UObject* Object);
+
+	FString GetCacheFilename() const;
+	void LoadCache();
+	void SaveCache();
+};
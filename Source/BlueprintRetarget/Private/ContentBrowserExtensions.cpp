@@ -1,6 +1,21 @@
 // Copyright 2015-2020 Piperift. All Rights Reserved.
 
 #include "ContentBrowserExtensions.h"
+#include "BrokenBlueprintIndex.h"
+#include "BlueprintRetargeter.h"
+#include "RetargetHierarchy.h"
+#include "RetargetAsyncLoad.h"
+#include "RetargetJob.h"
+#include "RetargetReferencers.h"
+#include "RetargetUtils.h"
+#include "RetargetBlueprintFilter.h"
+#include "RetargetSuggestions.h"
+#include "RetargetRedirects.h"
+#include "RetargetStats.h"
+#include "RetargetBackup.h"
+#include "RetargetPackageSaver.h"
+#include "RetargetJournal.h"
+#include "BlueprintRetarget.h"
 
 #include <CoreGlobals.h>
 #include <AssetToolsModule.h>
@@ -12,82 +27,49 @@
 #include <Framework/Commands/UIAction.h>
 #include <Framework/Commands/UICommandInfo.h>
 #include <Framework/MultiBox/MultiBoxBuilder.h>
-#include <Framework/Notifications/NotificationManager.h>
-#include <Widgets/Notifications/SNotificationList.h>
+#include <HAL/IConsoleManager.h>
+#include <HAL/FileManager.h>
 #include <Misc/ConfigCacheIni.h>
 #include <Misc/MessageDialog.h>
-#include <Dialogs/Dialogs.h>
+#include <Framework/Notifications/NotificationManager.h>
+#include <Widgets/Notifications/SNotificationList.h>
+#include <Misc/PackageName.h>
 
-#include <ScopedTransaction.h>
 #include <Engine/Blueprint.h>
 #include <ClassViewerModule.h>
-#include <ClassViewerFilter.h>
 #include <Kismet2/SClassPickerDialog.h>
-#include <Kismet2/KismetEditorUtilities.h>
-#include <Kismet2/CompilerResultsLog.h>
-#include <Kismet2/BlueprintEditorUtils.h>
-
-#include <GameFramework/Actor.h>
-#include <Components/ActorComponent.h>
-#include <Animation/AnimBlueprint.h>
-#include <Animation/AnimInstance.h>
-#include <Engine/LevelScriptActor.h>
-#include <Engine/SCS_Node.h>
-#include <Engine/SimpleConstructionScript.h>
 
 
 #define LOCTEXT_NAMESPACE "BlueprintRetarget"
 
+/** Suggestions below this score won't be preselected */
+static constexpr float MinSuggestionScore = 0.3f;
 
-class FRetargetBlueprintFilter : public IClassViewerFilter
-{
-public:
-	/** All children of these classes will be included unless filtered out by another setting. */
-	TSet< const UClass* > AllowedChildrenOfClasses;
-
-	/** Classes to not allow any children of into the Class Viewer/Picker. */
-	TSet< const UClass* > DisallowedChildrenOfClasses;
-
-	/** Classes to never show in this class viewer. */
-	TSet< const UClass* > DisallowedClasses;
-
-	/** Will limit the results to only native classes */
-	bool bShowNativeOnly;
+static TAutoConsoleVariable<FString> CVarRetargetStatsCsv(
+	TEXT("BlueprintRetarget.StatsCsv"),
+	TEXT(""),
+	TEXT("If set, the time and memory of each retarget phase is written to this csv file after retargeting"));
 
-	FRetargetBlueprintFilter()
-		: bShowNativeOnly(false)
-	{}
+static TAutoConsoleVariable<bool> CVarRetargetBulkMode(
+	TEXT("BlueprintRetarget.BulkMode"),
+	false,
+	TEXT("If true, retargets don't use the undo buffer. Package files are backed up under Saved/BlueprintRetarget/Backups instead"));
 
-	virtual bool IsClassAllowed(const FClassViewerInitializationOptions& InInitOptions, const UClass* InClass, TSharedRef< FClassViewerFilterFuncs > InFilterFuncs) override
-	{
-		// If it appears on the allowed child-of classes list (or there is nothing on that list)
-		//		AND it is NOT on the disallowed child-of classes list
-		//		AND it is NOT on the disallowed classes list
-		return InFilterFuncs->IfInChildOfClassesSet(AllowedChildrenOfClasses, InClass) != EFilterReturn::Failed &&
-			InFilterFuncs->IfInChildOfClassesSet(DisallowedChildrenOfClasses, InClass) != EFilterReturn::Passed &&
-			InFilterFuncs->IfInClassesSet(DisallowedClasses, InClass) != EFilterReturn::Passed &&
-			!InClass->HasAnyClassFlags(CLASS_Deprecated) &&
-			((bShowNativeOnly && InClass->HasAnyClassFlags(CLASS_Native)) || !bShowNativeOnly);
-	}
-
-	virtual bool IsUnloadedClassAllowed(const FClassViewerInitializationOptions& InInitOptions, const TSharedRef< const IUnloadedBlueprintData > InUnloadedClassData, TSharedRef< FClassViewerFilterFuncs > InFilterFuncs) override
-	{
-		// If it appears on the allowed child-of classes list (or there is nothing on that list)
-		//		AND it is NOT on the disallowed child-of classes list
-		//		AND it is NOT on the disallowed classes list
-		return InFilterFuncs->IfInChildOfClassesSet(AllowedChildrenOfClasses, InUnloadedClassData) != EFilterReturn::Failed &&
-			InFilterFuncs->IfInChildOfClassesSet(DisallowedChildrenOfClasses, InUnloadedClassData) != EFilterReturn::Passed &&
-			InFilterFuncs->IfInClassesSet(DisallowedClasses, InUnloadedClassData) != EFilterReturn::Passed &&
-			!InUnloadedClassData->HasAnyClassFlags(CLASS_Deprecated) &&
-			((bShowNativeOnly && InUnloadedClassData->HasAnyClassFlags(CLASS_Native)) || !bShowNativeOnly);
-	}
-};
+static TAutoConsoleVariable<int32> CVarRetargetChunkMemory(
+	TEXT("BlueprintRetarget.ChunkMemoryMB"),
+	4096,
+	TEXT("In bulk mode, blueprints are loaded, retargeted, saved and unloaded in chunks estimated to use this memory. 0 processes all at once"));
 
+static TAutoConsoleVariable<bool> CVarRetargetSave(
+	TEXT("BlueprintRetarget.Save"),
+	true,
+	TEXT("In bulk mode, if true, retargeted blueprints are checked out and saved in a batch, instead of being left for the editor save prompt"));
 
 //////////////////////////////////////////////////////////////////////////
 
 FContentBrowserMenuExtender_SelectedAssets ContentBrowserExtenderDelegate;
 FDelegateHandle ContentBrowserExtenderDelegateHandle;
+FDelegateHandle FilesLoadedDelegateHandle;
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -114,331 +96,503 @@ struct FRetargetClassExtension : public FContentBrowserSelectedAssetExtensionBas
 
 	virtual void Execute() override
 	{
-		// Only cache Blueprint assets
-		TArray<UBlueprint*> BPs;
-		for (auto AssetIt = SelectedAssets.CreateConstIterator(); AssetIt; ++AssetIt)
+		if (FRetargetJob::IsAnyRunning())
+		{
+			FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("RetargetRunning", "Blueprints are already being retargeted. Wait for it to finish or cancel it first."));
+			return;
+		}
+
+		// Only the roots of the selected hierarchy need a new parent
+		FRetargetHierarchy Hierarchy{ SelectedAssets };
+
+		// Parents that were only renamed or moved get fixed without loading any blueprint
+		if (RedirectMovedParents(Hierarchy))
 		{
-			const FAssetData& AssetData = *AssetIt;
-			if (TAssetPtr<UBlueprint> BP = Cast<UBlueprint>(AssetData.GetAsset()))
+			TArray<FAssetData> StillBroken;
+			for (const TArray<int32>& Batch : Hierarchy.Batches)
 			{
-				BPs.Add(BP.Get());
+				if (FRetargetUtils::IsInvalidBlueprint(Hierarchy.Nodes[Batch[0]].AssetData))
+				{
+					for (int32 Node : Batch)
+					{
+						StillBroken.Add(Hierarchy.Nodes[Node].AssetData);
+					}
+				}
 			}
+
+			if (StillBroken.Num() <= 0)
+			{
+				return;
+			}
+			Hierarchy = FRetargetHierarchy{ StillBroken };
+		}
+
+		TArray<FAssetData> RootAssets;
+		for (int32 Root : Hierarchy.Roots)
+		{
+			RootAssets.Add(Hierarchy.Nodes[Root].AssetData);
+		}
+
+		const int64 ChunkMemoryBudget = GetChunkMemoryBudget();
+		TArray<TArray<FAssetData>> Chunks = Hierarchy.SplitByMemory(ChunkMemoryBudget);
+		if (Chunks.Num() <= 0)
+		{
+			return;
 		}
 
+		// Load in the background while the user picks a class. Only the first chunk if there are many
+		TSharedPtr<FRetargetAsyncLoad> Load = MakeShared<FRetargetAsyncLoad>(Chunks[0]);
+		Load->Start();
+
 		const FText WarningTitle = LOCTEXT("RetargetWarningTitle", "WARNING");
 		EAppReturnType::Type Result = FMessageDialog::Open(EAppMsgType::OkCancel, EAppReturnType::Ok,
 			LOCTEXT("RetargetWarning", "This tool is ONLY intended to fix missing or invalid blueprint parents.\n\nDo not try to reparent a working blueprint with it. Assigning parent classes that changed or are unrelated may corrupt your blueprint."),
 			&WarningTitle
 		);
 
-		if (Result == EAppReturnType::Cancel)
+		if (Result == EAppReturnType::Cancel || Load->IsCancelled())
+		{
+			Load->Cancel();
 			return;
+		}
 
-		// Assign a new parent class
-		UClass* ChosenClass{ SelectClass(BPs) };
-
-		if (ChosenClass)
+		// Blueprints of different types or missing parents can't share a parent. Each group gets its own
+		const TArray<TArray<FAssetData>> Groups = FRetargetBlueprintFilter::GroupByKind(RootAssets);
+		TMap<FName, UClass*> NewParents;
+		for (int32 GroupIndex = 0; GroupIndex < Groups.Num(); ++GroupIndex)
 		{
-			const FScopedTransaction Transaction(LOCTEXT("RetargetBlueprintParents", "Retarget Blueprint parents"));
-			for (auto* BP : BPs)
+			UClass* ChosenClass = SelectClass(Groups[GroupIndex], GroupIndex, Groups.Num());
+			if (!ChosenClass)
+			{
+				// Other groups can still be retargeted
+				continue;
+			}
+
+			for (const FAssetData& AssetData : Groups[GroupIndex])
 			{
-				ReparentBlueprint(BP, ChosenClass);
+				NewParents.Add(AssetData.ObjectPath, ChosenClass);
 			}
 		}
-	}
 
-	UClass* SelectClass(const TArray<UBlueprint*>& BPs)
-	{
-		// Class picker options
-		FClassViewerInitializationOptions Options;
+		if (NewParents.Num() <= 0 || !Load->Wait())
 		{
-			Options.Mode = EClassViewerMode::ClassPicker;
-			Options.DisplayMode = EClassViewerDisplayMode::TreeView;
-			Options.bShowObjectRootClass = true;
-
-			Options.bIsBlueprintBaseOnly = true; // Only want blueprint base classes
-			Options.bShowUnloadedBlueprints = true;
-
-			Options.ClassFilter = PrepareFilter(BPs);
+			Load->Cancel();
+			return;
 		}
+		// Loaded blueprints don't need to be kept referenced anymore
+		Load.Reset();
 
-		// Temporally hide custom picker from ClassPicker
-		bool bLastExpandCustomClasses = true;
-		GConfig->GetBool(TEXT("/Script/UnrealEd.UnrealEdOptions"), TEXT("bExpandClassPickerDefaultClassList"), bLastExpandCustomClasses, GEditorIni);
-		GConfig->SetBool(TEXT("/Script/UnrealEd.UnrealEdOptions"), TEXT("bExpandClassPickerDefaultClassList"), false, GEditorIni);
-
-		UClass* ChosenClass = nullptr;
-		const FText TitleText = LOCTEXT("ClassPickerTitle", "Pick Parent Class");
-		const bool bPressedOk = SClassPickerDialog::PickClass(TitleText, Options, ChosenClass, UBlueprint::StaticClass());
+		if (NewParents.Num() < RootAssets.Num())
+		{
+			// Skipped groups are left as they are, with their children
+			TArray<FAssetData> Kept;
+			for (const TArray<int32>& Batch : Hierarchy.Batches)
+			{
+				if (NewParents.Contains(Hierarchy.Nodes[Batch[0]].AssetData.ObjectPath))
+				{
+					for (int32 Node : Batch)
+					{
+						Kept.Add(Hierarchy.Nodes[Node].AssetData);
+					}
+				}
+			}
+			Hierarchy = FRetargetHierarchy{ Kept };
+			Chunks = Hierarchy.SplitByMemory(ChunkMemoryBudget);
+		}
 
-		// Restore custom picker config value
-		GConfig->SetBool(TEXT("/Script/UnrealEd.UnrealEdOptions"), TEXT("bExpandClassPickerDefaultClassList"), bLastExpandCustomClasses, GEditorIni);
+		StartJob(Hierarchy, Chunks, NewParents, false);
+	}
 
+	/** Bulk mode keeps memory flat by backing up files instead of recording every change for undo */
+	static bool IsBulkMode()
+	{
+		return CVarRetargetBulkMode.GetValueOnGameThread();
+	}
 
-		return bPressedOk? ChosenClass : nullptr;
+	/** Without undo, blueprints can also be saved and unloaded in chunks. @return 0 if everything is retargeted at once */
+	static int64 GetChunkMemoryBudget()
+	{
+		return IsBulkMode() ? int64(CVarRetargetChunkMemory.GetValueOnGameThread()) * 1024 * 1024 : 0;
 	}
 
-	TSharedPtr<FRetargetBlueprintFilter> PrepareFilter(const TArray<UBlueprint*> BPs)
+	/**
+	 * Removes from the chunks blueprints whose file can't be written, with their children, after telling the user.
+	 * @return false if the retarget was cancelled or nothing is left
+	 */
+	static bool SkipNotWritable(const FRetargetHierarchy& Hierarchy, const TMap<FName, FString>& NotWritable, TArray<TArray<FAssetData>>& Chunks)
 	{
-		// Gather BP information
-		TArray<const UClass*> BlueprintClasses{};
-		bool bHasParent = true;
-		bool bIsActor = false;
-		bool bIsAnimBlueprint = false;
-		bool bIsLevelScriptActor = false;
-		bool bIsComponentBlueprint = false;
-		for (auto BlueprintIt = BPs.CreateConstIterator(); (!bIsActor && !bIsAnimBlueprint) && BlueprintIt; ++BlueprintIt)
+		// Children of a skipped blueprint would compile against its old state. Parents always go first
+		TSet<FName> Skipped;
+		FString SkippedText;
+		for (int32 Index : Hierarchy.Order)
 		{
-			const UBlueprint* Blueprint = *BlueprintIt;
-
-			bIsAnimBlueprint |= Blueprint->IsA(UAnimBlueprint::StaticClass());
-
-			if (Blueprint->ParentClass)
-			{
-				bIsActor |= Blueprint->ParentClass->IsChildOf(AActor::StaticClass());
-				bIsLevelScriptActor |= Blueprint->ParentClass->IsChildOf(ALevelScriptActor::StaticClass());
-				bIsComponentBlueprint |= Blueprint->ParentClass->IsChildOf(UActorComponent::StaticClass());
-				if (Blueprint->GeneratedClass)
-				{
-					BlueprintClasses.Add(Blueprint->GeneratedClass);
-				}
-			}
-			else
+			const FRetargetHierarchy::FNode& Node = Hierarchy.Nodes[Index];
+			const FString* Reason = NotWritable.Find(Node.AssetData.PackageName);
+			if (Reason || (Node.Parent != INDEX_NONE && Skipped.Contains(Hierarchy.Nodes[Node.Parent].AssetData.PackageName)))
 			{
-				bHasParent = false;
+				Skipped.Add(Node.AssetData.PackageName);
+				SkippedText += FString::Printf(TEXT("\n%s: %s"), *Node.AssetData.PackageName.ToString(), Reason ? **Reason : TEXT("Parent can't be written"));
 			}
 		}
 
+		for (TArray<FAssetData>& Chunk : Chunks)
+		{
+			Chunk.RemoveAll([&Skipped](const FAssetData& AssetData) {
+				return Skipped.Contains(AssetData.PackageName);
+			});
+		}
+		Chunks.RemoveAll([](const TArray<FAssetData>& Chunk) { return Chunk.Num() <= 0; });
 
-		TSharedPtr<FRetargetBlueprintFilter> Filter = MakeShared<FRetargetBlueprintFilter>();
-
-		Filter->DisallowedChildrenOfClasses.Add(UInterface::StaticClass());
-		Filter->DisallowedChildrenOfClasses.Append(BlueprintClasses); // Can't re-parent to child BPs
-		for (UBlueprint* BP : BPs)
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("%i blueprints can't be written and won't be retargeted:%s"), Skipped.Num(), *SkippedText);
+		if (Chunks.Num() <= 0)
 		{
-			BP->GetReparentingRules(Filter->AllowedChildrenOfClasses, Filter->DisallowedChildrenOfClasses);
+			FMessageDialog::Open(EAppMsgType::Ok, FText::Format(LOCTEXT("NothingWritable", "None of the blueprints can be checked out or written:\n{0}"), FText::FromString(SkippedText)));
+			return false;
 		}
 
-		if (bIsActor)
+		const FText Title = LOCTEXT("NotWritableTitle", "Blueprints can't be checked out");
+		return FMessageDialog::Open(EAppMsgType::YesNo, EAppReturnType::Yes,
+			FText::Format(LOCTEXT("NotWritableMessage", "These blueprints can't be checked out or written, and won't be retargeted:\n{0}\n\nRetarget the rest?"), FText::FromString(SkippedText)),
+			&Title) == EAppReturnType::Yes;
+	}
+
+	/** Checks out and backs up all blueprints of the hierarchy, then retargets its chunks over several frames */
+	static void StartJob(const FRetargetHierarchy& Hierarchy, const TArray<TArray<FAssetData>>& InChunks, const TMap<FName, UClass*>& NewParents, bool bResumeJournal)
+	{
+		TArray<TArray<FAssetData>> Chunks = InChunks;
+		const bool bBulkMode = IsBulkMode();
+		const bool bUnloadChunks = bBulkMode && Chunks.Num() > 1;
+
+		// An undo transaction can't stay open while the editor keeps running, so undoable retargets are done in a single frame.
+		// Only bulk mode spreads them over several frames, backing up the files instead
+		const bool bTransact = !bBulkMode;
+
+		// All files are checked out in one request up front. Chunks are always saved before being unloaded.
+		// Undo can't revert saved files, so transacted retargets are left for the user to save
+		const bool bSave = !bTransact && (CVarRetargetSave.GetValueOnGameThread() || bUnloadChunks);
+		if (bSave)
 		{
-			if (bIsLevelScriptActor)
+			TArray<FName> PackageNames;
+			for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
 			{
-				// Don't allow conversion outside of the LevelScriptActor hierarchy
-				Filter->AllowedChildrenOfClasses.Add(ALevelScriptActor::StaticClass());
-				Filter->bShowNativeOnly = true;
+				PackageNames.Add(Node.AssetData.PackageName);
 			}
-			else
+			const TMap<FName, FString> NotWritable = FRetargetPackageSaver::CheckOut(PackageNames);
+			if (NotWritable.Num() > 0 && !SkipNotWritable(Hierarchy, NotWritable, Chunks))
 			{
-				// Don't allow conversion outside of the Actor hierarchy
-				Filter->AllowedChildrenOfClasses.Add(AActor::StaticClass());
-
-				// Don't allow non-LevelScriptActor->LevelScriptActor conversion
-				Filter->DisallowedChildrenOfClasses.Add(ALevelScriptActor::StaticClass());
+				return;
 			}
 		}
-		else if (bIsAnimBlueprint)
+
+		FString BackupDirectory;
+		if (!bTransact)
 		{
-			// If it's an anim blueprint, do not allow conversion to non anim
-			Filter->AllowedChildrenOfClasses.Add(UAnimInstance::StaticClass());
+			FRetargetBackup Backup;
+			if (!BackupPackages(Hierarchy, Backup))
+			{
+				return;
+			}
+			BackupDirectory = Backup.GetDirectory();
 		}
-		else if (bIsComponentBlueprint)
+
+		if (Chunks.Num() > 1)
 		{
-			// If it is a component blueprint, only allow classes under and including UActorComponent
-			Filter->AllowedChildrenOfClasses.Add(UActorComponent::StaticClass());
+			UE_LOG(LogBlueprintReparent, Log, TEXT("Retargeting %i blueprints in %i chunks of %lld MB"), Hierarchy.Nodes.Num(), Chunks.Num(), GetChunkMemoryBudget() / (1024 * 1024));
 		}
-		else if(bHasParent)
+
+		FRetargetProfiler::Get().Reset();
+		TSharedRef<FRetargetJob> Job = MakeShared<FRetargetJob>(Chunks, NewParents, bUnloadChunks, bTransact, bSave);
+		TWeakPtr<FRetargetJob> WeakJob = Job;
+		Job->OnFinished.BindLambda([BackupDirectory, WeakJob]() {
+			if (!BackupDirectory.IsEmpty())
+			{
+				NotifyBackup(BackupDirectory);
+			}
+
+			TSharedPtr<FRetargetJob> FinishedJob = WeakJob.Pin();
+			if (FinishedJob && FinishedJob->GetRetargetedPackages().Num() > 0)
+			{
+				NotifyReferencers(FinishedJob->GetRetargetedPackages());
+			}
+
+			FRetargetProfiler::Get().PrintSummary();
+			const FString StatsFile = CVarRetargetStatsCsv.GetValueOnGameThread();
+			if (!StatsFile.IsEmpty())
+			{
+				FRetargetProfiler::Get().WriteCsv(StatsFile);
+			}
+		});
+		Job->Start(bResumeJournal);
+	}
+
+	/**
+	 * Retargets what an interrupted job left, with the parents it had chosen. The blueprint it crashed on is quarantined.
+	 * Blueprints that were compiled together when it crashed go in their own chunks, still after their parents,
+	 * so that a new crash points to one of them
+	 */
+	static void ResumeJob()
+	{
+		if (FRetargetJob::IsAnyRunning())
 		{
-			Filter->DisallowedChildrenOfClasses.Add(AActor::StaticClass());
+			FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("RetargetRunning", "Blueprints are already being retargeted. Wait for it to finish or cancel it first."));
+			return;
 		}
 
-		for (const UBlueprint* BP : BPs)
+		FRetargetJournalContents Contents;
+		TArray<FName> Suspects;
 		{
-			// don't allow making me my own parent!
-			if (BP->GeneratedClass)
+			// The job opens the journal again
+			FRetargetJournal Journal;
+			if (!Journal.Resume(FRetargetJournal::GetDefaultFilename(), Contents, Suspects))
 			{
-				Filter->DisallowedClasses.Add(BP->GeneratedClass);
+				return;
 			}
 		}
-		return Filter;
-	}
 
-	void ReparentBlueprint(UBlueprint* Blueprint, UClass* ChosenClass) {
-		check(Blueprint);
-
-		if ((Blueprint != nullptr) && (ChosenClass != nullptr) && (ChosenClass != Blueprint->ParentClass))
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		TArray<FAssetData> Assets;
+		TMap<FName, UClass*> NewParents;
+		for (const auto& Entry : Contents.Entries)
 		{
-			// Notify user, about common interfaces
-			bool bReparent = true;
+			if (Entry.Value.IsDone())
 			{
-				FString CommonInterfacesNames;
-				for (const FBPInterfaceDescription& InterdaceDesc : Blueprint->ImplementedInterfaces)
-				{
-					if (ChosenClass->ImplementsInterface(*InterdaceDesc.Interface))
-					{
-						CommonInterfacesNames += InterdaceDesc.Interface->GetName();
-						CommonInterfacesNames += TCHAR('\n');
-					}
-				}
-				if (!CommonInterfacesNames.IsEmpty())
-				{
-					const FText Title = LOCTEXT("CommonInterfacesTitle", "Common interfaces");
-					const FText Message = FText::Format(
-						LOCTEXT("ReparentWarning_InterfacesImplemented", "Following interfaces are already implemented. Continue reparenting? \n {0}"),
-						FText::FromString(CommonInterfacesNames));
-
-					FSuppressableWarningDialog::FSetupInfo Info(Message, Title, "Warning_CommonInterfacesWhileReparenting");
-					Info.ConfirmText = LOCTEXT("ReparentYesButton", "Reparent");
-					Info.CancelText = LOCTEXT("ReparentNoButton", "Cancel");
-
-					if (FSuppressableWarningDialog(Info).ShowModal() == FSuppressableWarningDialog::Cancel)
-					{
-						bReparent = false;
-					}
-				}
+				continue;
 			}
 
-			// If the chosen class differs hierarchically from the current class, warn that there may be data loss
-			if (bReparent && (!Blueprint->ParentClass || !ChosenClass->GetDefaultObject()->IsA(Blueprint->ParentClass)))
+			TArray<FAssetData> PackageAssets;
+			AssetRegistry.GetAssetsByPackageName(Entry.Key, PackageAssets);
+			const FAssetData* Blueprint = PackageAssets.FindByPredicate([](const FAssetData& AssetData) {
+				return FRetargetUtils::IsBlueprintAsset(AssetData);
+			});
+			if (!Blueprint)
 			{
-				const FText Title   = LOCTEXT("ReparentTitle", "Reparent Blueprint");
-				const FText Message = LOCTEXT("ReparentWarning", "Reparenting this blueprint may cause data loss.  Continue reparenting?");
-
-				// Warn the user that this may result in data loss
-				FSuppressableWarningDialog::FSetupInfo Info(Message, Title, "Warning_ReparentTitle");
-				Info.ConfirmText = LOCTEXT("ReparentYesButton", "Reparent");
-				Info.CancelText = LOCTEXT("ReparentNoButton", "Cancel");
-				Info.CheckBoxText = FText::GetEmpty();	// not suppressible
-
-				if (FSuppressableWarningDialog(Info).ShowModal() == FSuppressableWarningDialog::Cancel)
-				{
-					bReparent = false;
-				}
+				UE_LOG(LogBlueprintReparent, Warning, TEXT("%s is not a blueprint anymore. It won't be resumed"), *Entry.Key.ToString());
+				continue;
 			}
 
-			if (bReparent)
+			if (!Entry.Value.NewParent.IsEmpty())
 			{
-				UE_LOG(LogBlueprintReparent, Warning, TEXT("Reparenting blueprint %s from %s to %s..."), *Blueprint->GetFullName(), Blueprint->ParentClass ? *Blueprint->ParentClass->GetName() : TEXT("[None]"), *ChosenClass->GetName());
-
-				UClass* OldParentClass = Blueprint->ParentClass;
-				Blueprint->ParentClass = ChosenClass;
-
-				// Ensure that the Blueprint is up-to-date (valid SCS etc.) before compiling
-				EnsureBlueprintIsUpToDate(Blueprint);
-				FBlueprintEditorUtils::RefreshAllNodes(Blueprint);
-				FBlueprintEditorUtils::MarkBlueprintAsModified(Blueprint);
-
-				Compile(Blueprint);
-
-				// Ensure that the Blueprint is up-to-date (valid SCS etc.) after compiling (new parent class)
-				EnsureBlueprintIsUpToDate(Blueprint);
-
-				if (Blueprint->NativizationFlag != EBlueprintNativizationFlag::Disabled)
+				if (UClass* NewParent = LoadObject<UClass>(nullptr, *Entry.Value.NewParent))
 				{
-					UBlueprint* ParentBlueprint = UBlueprint::GetBlueprintFromClass(ChosenClass);
-					if (ParentBlueprint && ParentBlueprint->NativizationFlag == EBlueprintNativizationFlag::Disabled)
-					{
-						ParentBlueprint->NativizationFlag = EBlueprintNativizationFlag::Dependency;
-
-						FNotificationInfo Warning(FText::Format(
-							LOCTEXT("InterfaceFlaggedForNativization", "{0} flagged for nativization (as a required dependency)."),
-							FText::FromName(ParentBlueprint->GetFName())
-						));
-						Warning.ExpireDuration = 5.0f;
-						Warning.bFireAndForget = true;
-						Warning.Image = FCoreStyle::Get().GetBrush(TEXT("MessageLog.Warning"));
-						FSlateNotificationManager::Get().AddNotification(Warning);
-					}
+					NewParents.Add(Blueprint->ObjectPath, NewParent);
 				}
-
-				/*if (SCSEditor.IsValid())
-				{
-					SCSEditor->UpdateTree();
-				}*/
 			}
+
+			Assets.Add(*Blueprint);
 		}
 
-		FSlateApplication::Get().DismissAllMenus();
-	}
+		if (Assets.Num() <= 0)
+		{
+			FRetargetJournal Journal;
+			Journal.Open(FRetargetJournal::GetDefaultFilename(), true);
+			Journal.Finish();
+			return;
+		}
 
-	void Compile(UBlueprint* Blueprint) {
-		check(Blueprint);
+		// Suspects still go after their parents, so that they compile against the fixed ones
+		const FRetargetHierarchy Hierarchy{ Assets };
+		StartJob(Hierarchy, Hierarchy.SplitByMemory(GetChunkMemoryBudget(), Suspects), NewParents, true);
+	}
 
-		FCompilerResultsLog LogResults;
-		LogResults.SetSourcePath(Blueprint->GetPathName());
-		LogResults.BeginEvent(TEXT("Compile"));
-		FKismetEditorUtilities::CompileBlueprint(Blueprint, EBlueprintCompileOptions::None, &LogResults);
+	/** Copies the files of all blueprints that will be modified. @return false if any failed */
+	static bool BackupPackages(const FRetargetHierarchy& Hierarchy, FRetargetBackup& Backup)
+	{
+		bool bSucceeded = true;
+		for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
+		{
+			bSucceeded &= Backup.Add(Node.AssetData.PackageName);
+		}
+		bSucceeded = bSucceeded && Backup.Save();
 
-		LogResults.EndEvent();
+		if (!bSucceeded)
+		{
+			FMessageDialog::Open(EAppMsgType::Ok, FText::Format(
+				LOCTEXT("BackupFailed", "Couldn't backup the blueprints to '{0}'. Nothing was retargeted."),
+				FText::FromString(Backup.GetDirectory())));
+		}
+		return bSucceeded;
 	}
 
-	void EnsureBlueprintIsUpToDate(UBlueprint* Blueprint) {
+	static void NotifyBackup(const FString& BackupDirectory)
+	{
+		FNotificationInfo Info(LOCTEXT("BulkRetargetDone", "Blueprints retargeted without undo. Their previous files were backed up"));
+		Info.ExpireDuration = 10.f;
+		Info.bFireAndForget = true;
+		Info.ButtonDetails.Add(FNotificationButtonInfo(
+			LOCTEXT("RestoreBackup", "Restore backups"),
+			LOCTEXT("RestoreBackup_Tooltip", "Restores the blueprints as they were before retargeting"),
+			FSimpleDelegate::CreateLambda([BackupDirectory]() {
+				FBlueprintRetargetContentBrowserExtensions::RestoreBackup(BackupDirectory);
+			}),
+			SNotificationItem::CS_None
+		));
+		FSlateNotificationManager::Get().AddNotification(Info);
+	}
 
-		// Purge any nullptr graphs
-		FBlueprintEditorUtils::PurgeNullGraphs(Blueprint);
+	/** Offers recompiling only the blueprints that depend on the retargeted ones */
+	static void NotifyReferencers(const TArray<FName>& RetargetedPackages)
+	{
+		TSharedRef<FRetargetReferencers> Referencers = MakeShared<FRetargetReferencers>(RetargetedPackages);
+		if (Referencers->GetAffected().Num() <= 0)
+		{
+			return;
+		}
 
-		// Make sure the blueprint is cosmetically up to date
-		FKismetEditorUtilities::UpgradeCosmeticallyStaleBlueprint(Blueprint);
+		FNotificationInfo Info(FText::Format(LOCTEXT("ReferencersFound", "{0} other blueprints depend on the retargeted blueprints"),
+			FText::AsNumber(Referencers->GetAffected().Num())));
+		Info.ExpireDuration = 10.f;
+		Info.bFireAndForget = true;
+		Info.ButtonDetails.Add(FNotificationButtonInfo(
+			LOCTEXT("RecompileReferencers", "Recompile them"),
+			LOCTEXT("RecompileReferencers_Tooltip", "Recompiles blueprints that depend on the retargeted ones, in dependency order. Blueprints whose dependencies didn't change are skipped"),
+			FSimpleDelegate::CreateLambda([Referencers]() {
+				const FRetargetReferencersResult Result = Referencers->Recompile();
+
+				FNotificationInfo ResultInfo(FText::Format(LOCTEXT("ReferencersRecompiled", "Recompiled {0} blueprints, {1} with errors. {2} didn't need it"),
+					FText::AsNumber(Result.Recompiled.Num()), FText::AsNumber(Result.Failed.Num()), FText::AsNumber(Result.NumSkipped)));
+				ResultInfo.ExpireDuration = 5.f;
+				ResultInfo.Image = FCoreStyle::Get().GetBrush(Result.Failed.Num() > 0 ? TEXT("MessageLog.Warning") : TEXT("MessageLog.Note"));
+				FSlateNotificationManager::Get().AddNotification(ResultInfo);
+			}),
+			SNotificationItem::CS_None
+		));
+		FSlateNotificationManager::Get().AddNotification(Info);
+	}
 
-		if (FBlueprintEditorUtils::SupportsConstructionScript(Blueprint))
+	/**
+	 * Offers class redirects for roots whose missing parent exists with the same name somewhere else
+	 * @return true if any redirect was added
+	 */
+	bool RedirectMovedParents(const FRetargetHierarchy& Hierarchy)
+	{
+		TMap<FString, TArray<FAssetData>> RootsByMissingParent;
+		for (int32 Root : Hierarchy.Roots)
 		{
-			// If we don't have an SCS yet, make it
-			if (Blueprint->GeneratedClass && !Blueprint->SimpleConstructionScript)
+			const FAssetData& AssetData = Hierarchy.Nodes[Root].AssetData;
+			const FString MissingParentPath = FRetargetUtils::FindUnresolvedParentPath(AssetData);
+			if (!MissingParentPath.IsEmpty())
 			{
-				Blueprint->SimpleConstructionScript = NewObject<USimpleConstructionScript>(Blueprint->GeneratedClass);
-				Blueprint->SimpleConstructionScript->SetFlags(RF_Transactional);
+				RootsByMissingParent.FindOrAdd(MissingParentPath).Add(AssetData);
 			}
+		}
 
-			// If we should have a UCS but don't yet, make it
-			if (!FBlueprintEditorUtils::FindUserConstructionScript(Blueprint))
+		TMap<FString, FString> MovedClasses;
+		FString MovedClassesText;
+		for (const auto& Group : RootsByMissingParent)
+		{
+			UClass* MovedClass = FRetargetRedirects::FindMovedClass(Group.Key);
+			if (MovedClass && FRetargetRedirects::HasMatchingLayout(MovedClass, Group.Value))
 			{
-				UEdGraph* UCSGraph = FBlueprintEditorUtils::CreateNewGraph(Blueprint, UEdGraphSchema_K2::FN_UserConstructionScript, UEdGraph::StaticClass(), UEdGraphSchema_K2::StaticClass());
-				FBlueprintEditorUtils::AddFunctionGraph(Blueprint, UCSGraph, /*bIsUserCreated=*/ false, AActor::StaticClass());
-				UCSGraph->bAllowDeletion = false;
+				MovedClasses.Add(Group.Key, MovedClass->GetPathName());
+				MovedClassesText += FString::Printf(TEXT("\n%s -> %s"), *Group.Key, *MovedClass->GetPathName());
 			}
+		}
+
+		if (MovedClasses.Num() <= 0)
+		{
+			return false;
+		}
 
-			// Check to see if we have gained a component from our parent (that would require us removing our scene root)
-			// (or lost one, which requires adding one)
-			if (Blueprint->SimpleConstructionScript != nullptr)
+		const FText RedirectTitle = LOCTEXT("RedirectTitle", "Renamed parent classes");
+		const EAppReturnType::Type Result = FMessageDialog::Open(EAppMsgType::YesNo, EAppReturnType::Yes,
+			FText::Format(LOCTEXT("RedirectMessage", "These parent classes seem to have been renamed or moved:\n{0}\n\nAdd class redirects to DefaultEngine.ini instead of reparenting?\nBlueprints will be fixed without being loaded, compiled or saved."),
+				FText::FromString(MovedClassesText)),
+			&RedirectTitle
+		);
+		if (Result != EAppReturnType::Yes)
+		{
+			return false;
+		}
+
+		bool bRedirected = false;
+		for (const auto& MovedClass : MovedClasses)
+		{
+			if (FRetargetRedirects::AddClassRedirect(MovedClass.Key, MovedClass.Value))
 			{
-				Blueprint->SimpleConstructionScript->ValidateSceneRootNodes();
+				bRedirected = true;
+				FBrokenBlueprintIndex::Get().RefreshDependents(FName(*FPackageName::ObjectPathToPackageName(MovedClass.Key)));
 			}
 		}
-		else
+		return bRedirected;
+	}
+
+	/** Shows the class picker for a group of blueprints that accept the same parents */
+	UClass* SelectClass(const TArray<FAssetData>& Assets, int32 GroupIndex, int32 NumGroups)
+	{
+		// Class picker options
+		FClassViewerInitializationOptions Options;
 		{
-			// If we have an SCS but don't support it, then we remove it
-			if (Blueprint->SimpleConstructionScript)
-			{
-				// Remove any SCS variable nodes
-				for (USCS_Node* SCS_Node : Blueprint->SimpleConstructionScript->GetAllNodes())
-				{
-					if (SCS_Node)
-					{
-						FBlueprintEditorUtils::RemoveVariableNodes(Blueprint, SCS_Node->GetVariableName());
-					}
-				}
+			Options.Mode = EClassViewerMode::ClassPicker;
+			Options.DisplayMode = EClassViewerDisplayMode::TreeView;
+			Options.bShowObjectRootClass = true;
 
-				// Remove the SCS object reference
-				Blueprint->SimpleConstructionScript = nullptr;
+			Options.bIsBlueprintBaseOnly = true; // Only want blueprint base classes
+			Options.bShowUnloadedBlueprints = true;
+
+			TSharedRef<FRetargetBlueprintFilter> Filter = FRetargetBlueprintFilter::Create(Assets);
+			Options.ClassFilter = Filter;
+			Options.InitiallySelectedClass = SuggestClass(Assets, *Filter);
+		}
+
+		// Temporally hide custom picker from ClassPicker
+		bool bLastExpandCustomClasses = true;
+		GConfig->GetBool(TEXT("/Script/UnrealEd.UnrealEdOptions"), TEXT("bExpandClassPickerDefaultClassList"), bLastExpandCustomClasses, GEditorIni);
+		GConfig->SetBool(TEXT("/Script/UnrealEd.UnrealEdOptions"), TEXT("bExpandClassPickerDefaultClassList"), false, GEditorIni);
 
-				// Mark the Blueprint as having been structurally modified
-				FBlueprintEditorUtils::MarkBlueprintAsStructurallyModified(Blueprint);
+		UClass* ChosenClass = nullptr;
+		FText TitleText = LOCTEXT("ClassPickerTitle", "Pick Parent Class");
+		if (NumGroups > 1)
+		{
+			FString MissingParentPath = FRetargetUtils::FindUnresolvedParentPath(Assets[0]);
+			if (MissingParentPath.IsEmpty())
+			{
+				MissingParentPath = FRetargetUtils::GetParentClassPath(Assets[0]);
 			}
+
+			TitleText = FText::Format(LOCTEXT("ClassPickerGroupTitle", "Pick Parent Class ({0}/{1}): {2} {3} missing {4}"),
+				FText::AsNumber(GroupIndex + 1), FText::AsNumber(NumGroups), FText::AsNumber(Assets.Num()),
+				FText::FromName(Assets[0].AssetClass), FText::FromString(FPackageName::ObjectPathToObjectName(MissingParentPath)));
 		}
+		const bool bPressedOk = SClassPickerDialog::PickClass(TitleText, Options, ChosenClass, UBlueprint::StaticClass());
 
-		// Make sure that this blueprint is up-to-date with regards to its parent functions
-		FBlueprintEditorUtils::ConformCallsToParentFunctions(Blueprint);
+		// Restore custom picker config value
+		GConfig->SetBool(TEXT("/Script/UnrealEd.UnrealEdOptions"), TEXT("bExpandClassPickerDefaultClassList"), bLastExpandCustomClasses, GEditorIni);
 
-		// Make sure that this blueprint is up-to-date with regards to its implemented events
-		FBlueprintEditorUtils::ConformImplementedEvents(Blueprint);
 
-		// Make sure that this blueprint is up-to-date with regards to its implemented interfaces
-		FBlueprintEditorUtils::ConformImplementedInterfaces(Blueprint);
+		return bPressedOk? ChosenClass : nullptr;
+	}
 
-		// Update old composite nodes(can't do this in PostLoad)
-		FBlueprintEditorUtils::UpdateOutOfDateCompositeNodes(Blueprint);
+	/** @return the most likely replacement of the missing parent, if any is good enough */
+	UClass* SuggestClass(const TArray<FAssetData>& Assets, FRetargetBlueprintFilter& Filter)
+	{
+		if (Assets.Num() <= 0)
+		{
+			return nullptr;
+		}
 
-		// Update any nodes which might have dropped their RF_Transactional flag due to copy-n-paste issues
-		FBlueprintEditorUtils::UpdateTransactionalFlags(Blueprint);
+		FString MissingParentPath = FRetargetUtils::FindUnresolvedParentPath(Assets[0]);
+		if (MissingParentPath.IsEmpty())
+		{
+			MissingParentPath = FRetargetUtils::GetParentClassPath(Assets[0]);
+		}
+
+		// Blueprints that finished loading also tell us what they use from their parent
+		FParentMemberUsage Usage;
+		for (const FAssetData& AssetData : Assets)
+		{
+			if (AssetData.IsAssetLoaded())
+			{
+				Usage.Gather(Cast<UBlueprint>(AssetData.FastGetAsset(false)));
+			}
+		}
+
+		const TArray<FRetargetSuggestion> Suggestions = FRetargetSuggestions::Get().Suggest(MissingParentPath, Usage, &Filter, 1);
+		if (Suggestions.Num() > 0 && Suggestions[0].Score >= MinSuggestionScore)
+		{
+			UE_LOG(LogBlueprintReparent, Log, TEXT("Suggested %s as new parent of %s (score %.2f)"), *Suggestions[0].Class->GetPathName(), *MissingParentPath, Suggestions[0].Score);
+			return Suggestions[0].Class.Get();
+		}
+		return nullptr;
 	}
 };
 
@@ -475,11 +629,12 @@ public:
 
 	static TSharedRef<FExtender> OnExtendContentBrowserAssetSelectionMenu(const TArray<FAssetData>& SelectedAssets)
 	{
-		// Run through the assets to determine if any meet our criteria
+		// Run through the assets to determine if any meet our criteria.
+		// Only registry tags are checked here, assets get loaded once the action is executed
 		bool bAllInvalidBlueprint = SelectedAssets.Num() > 0;
-		for (auto AssetIt = SelectedAssets.CreateConstIterator(); AssetIt; ++AssetIt)
+		for (auto AssetIt = SelectedAssets.CreateConstIterator(); bAllInvalidBlueprint && AssetIt; ++AssetIt)
 		{
-			bAllInvalidBlueprint &= IsInvalidBlueprint(Cast<UBlueprint>(AssetIt->GetAsset()));
+			bAllInvalidBlueprint &= FBrokenBlueprintIndex::Get().IsBroken(*AssetIt);
 		}
 
 		TSharedRef<FExtender> Extender(new FExtender());
@@ -502,10 +657,6 @@ public:
 		FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>(TEXT("ContentBrowser"));
 		return ContentBrowserModule.GetAllAssetViewContextMenuExtenders();
 	}
-
-	static bool IsInvalidBlueprint(const TAssetPtr<UBlueprint>& BP) {
-		return BP && (!BP->SkeletonGeneratedClass || !BP->GeneratedClass);
-	}
 };
 
 
@@ -525,6 +676,101 @@ void FBlueprintRetargetContentBrowserExtensions::RemoveHooks()
 {
 	TArray<FContentBrowserMenuExtender_SelectedAssets>& CBMenuExtenderDelegates = FBlueprintRetargetContentBrowserExtensions_Impl::GetExtenderDelegates();
 	CBMenuExtenderDelegates.RemoveAll([](const FContentBrowserMenuExtender_SelectedAssets& Delegate) { return Delegate.GetHandle() == ContentBrowserExtenderDelegateHandle; });
+
+	if (FAssetRegistryModule* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>(TEXT("AssetRegistry")))
+	{
+		AssetRegistryModule->Get().OnFilesLoaded().Remove(FilesLoadedDelegateHandle);
+	}
+}
+
+void FBlueprintRetargetContentBrowserExtensions::RetargetAssets(const TArray<FAssetData>& Assets)
+{
+	TSharedPtr<FRetargetClassExtension> Functor = MakeShared<FRetargetClassExtension>();
+	Functor->SelectedAssets = Assets;
+	Functor->Execute();
+}
+
+void FBlueprintRetargetContentBrowserExtensions::RestoreBackup(const FString& BackupDirectory)
+{
+	const FString Directory = BackupDirectory.IsEmpty() ? FRetargetBackup::FindLatest() : BackupDirectory;
+	if (Directory.IsEmpty())
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("NoBackup", "There are no retarget backups to restore."));
+		return;
+	}
+
+	const EAppReturnType::Type Result = FMessageDialog::Open(EAppMsgType::OkCancel, FText::Format(
+		LOCTEXT("RestoreBackupConfirm", "Restore the blueprints backed up at '{0}'?\n\nAny change made to them since will be lost."),
+		FText::FromString(Directory)));
+	if (Result != EAppReturnType::Ok)
+	{
+		return;
+	}
+
+	const int32 Restored = FRetargetBackup::Restore(Directory);
+
+	FNotificationInfo Info(FText::Format(LOCTEXT("BackupRestored", "Restored {0} blueprints"), FText::AsNumber(Restored)));
+	Info.ExpireDuration = 5.f;
+	FSlateNotificationManager::Get().AddNotification(Info);
+}
+
+void FBlueprintRetargetContentBrowserExtensions::OfferResume()
+{
+	FRetargetJournalContents Contents;
+	if (!FRetargetJournal::Read(FRetargetJournal::GetDefaultFilename(), Contents) || Contents.bFinished)
+	{
+		return;
+	}
+
+	// Blueprints left are found with the asset registry
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.OnFilesLoaded().Remove(FilesLoadedDelegateHandle);
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		FilesLoadedDelegateHandle = AssetRegistry.OnFilesLoaded().AddStatic(&FBlueprintRetargetContentBrowserExtensions::OfferResume);
+		return;
+	}
+
+	int32 NumLeft = 0;
+	for (const auto& Entry : Contents.Entries)
+	{
+		NumLeft += !Entry.Value.IsDone();
+	}
+
+	// Buttons need the notification to close it
+	TSharedRef<TWeakPtr<SNotificationItem>> Notification = MakeShared<TWeakPtr<SNotificationItem>>();
+	FNotificationInfo Info(FText::Format(LOCTEXT("ResumeRetarget", "A retarget was interrupted with {0} blueprints left. Resume it?"), FText::AsNumber(NumLeft)));
+	Info.bFireAndForget = false;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		LOCTEXT("ResumeRetargetButton", "Resume"),
+		LOCTEXT("ResumeRetargetButton_Tooltip", "Retargets the blueprints left with the parents chosen before. The blueprint being retargeted when it stopped is skipped"),
+		FSimpleDelegate::CreateLambda([Notification]() {
+			if (TSharedPtr<SNotificationItem> Item = Notification->Pin())
+			{
+				Item->ExpireAndFadeout();
+			}
+			FRetargetClassExtension::ResumeJob();
+		}),
+		SNotificationItem::CS_Pending
+	));
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		LOCTEXT("DiscardRetargetButton", "Discard"),
+		LOCTEXT("DiscardRetargetButton_Tooltip", "Forgets the interrupted retarget. Blueprints it saved keep their new parent"),
+		FSimpleDelegate::CreateLambda([Notification]() {
+			if (TSharedPtr<SNotificationItem> Item = Notification->Pin())
+			{
+				Item->ExpireAndFadeout();
+			}
+			IFileManager::Get().Delete(*FRetargetJournal::GetDefaultFilename(), false, false, true);
+		}),
+		SNotificationItem::CS_Pending
+	));
+
+	*Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (TSharedPtr<SNotificationItem> Item = Notification->Pin())
+	{
+		Item->SetCompletionState(SNotificationItem::CS_Pending);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
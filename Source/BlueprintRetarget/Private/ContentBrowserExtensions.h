@@ -8,4 +8,13 @@ class FBlueprintRetargetContentBrowserExtensions
 public:
 	static void InstallHooks();
 	static void RemoveHooks();
+
+	/** Starts retargeting assets as if it was done from the content browser */
+	static void RetargetAssets(const TArray<struct FAssetData>& Assets);
+
+	/** Asks for confirmation and restores the blueprints saved in a backup folder. Latest backup if empty */
+	static void RestoreBackup(const FString& BackupDirectory = {});
+
+	/** If a retarget got interrupted (E.g: the editor crashed), offers to resume it once assets are discovered */
+	static void OfferResume();
 };
\ No newline at end of file
@@ -0,0 +1,195 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetAsyncLoad.h"
+#include "RetargetUtils.h"
+
+#include <Engine/AssetManager.h>
+#include <Engine/StreamableManager.h>
+#include <Framework/Application/SlateApplication.h>
+#include <Framework/Notifications/NotificationManager.h>
+#include <Widgets/Notifications/SNotificationList.h>
+#include <Misc/ScopedSlowTask.h>
+#include <UObject/UObjectGlobals.h>
+
+
+#define LOCTEXT_NAMESPACE "BlueprintRetarget"
+
+
+FRetargetAsyncLoad::FRetargetAsyncLoad(const TArray<FAssetData>& InAssets)
+	: Assets(InAssets)
+{
+	AssetSizes.Reserve(Assets.Num());
+	for (const FAssetData& AssetData : Assets)
+	{
+		const int64 Size = FRetargetUtils::GetPackageDiskSize(AssetData);
+		AssetSizes.Add(Size);
+		TotalBytes += Size;
+	}
+}
+
+FRetargetAsyncLoad::~FRetargetAsyncLoad()
+{
+	if (FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnPreTick().Remove(PreTickHandle);
+	}
+
+	if (Handle.IsValid())
+	{
+		Handle->ReleaseHandle();
+	}
+}
+
+void FRetargetAsyncLoad::Start()
+{
+	TArray<FSoftObjectPath> Paths;
+	Paths.Reserve(Assets.Num());
+	for (const FAssetData& AssetData : Assets)
+	{
+		Paths.Add(AssetData.ToSoftObjectPath());
+	}
+	Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+
+	if (HasCompleted())
+	{
+		// Everything was already in memory
+		return;
+	}
+
+	FNotificationInfo Info(FText::GetEmpty());
+	Info.Text = TAttribute<FText>::Create(TAttribute<FText>::FGetter::CreateSP(this, &FRetargetAsyncLoad::GetProgressText));
+	Info.bFireAndForget = false;
+	Info.bUseThrobber = true;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		LOCTEXT("CancelLoad", "Cancel"),
+		LOCTEXT("CancelLoad_Tooltip", "Cancels loading and retargeting the blueprints"),
+		FSimpleDelegate::CreateSP(this, &FRetargetAsyncLoad::Cancel),
+		SNotificationItem::CS_Pending
+	));
+	Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (TSharedPtr<SNotificationItem> Item = Notification.Pin())
+	{
+		Item->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+
+	PreTickHandle = FSlateApplication::Get().OnPreTick().AddSP(this, &FRetargetAsyncLoad::OnPreTick);
+}
+
+void FRetargetAsyncLoad::Cancel()
+{
+	if (bCancelled)
+	{
+		return;
+	}
+	bCancelled = true;
+
+	if (Handle.IsValid())
+	{
+		Handle->CancelHandle();
+	}
+	CloseNotification(false);
+}
+
+bool FRetargetAsyncLoad::HasCompleted() const
+{
+	return Handle.IsValid() && Handle->HasLoadCompleted();
+}
+
+bool FRetargetAsyncLoad::Wait()
+{
+	if (bCancelled)
+	{
+		return false;
+	}
+
+	if (!HasCompleted())
+	{
+		int32 Loaded = 0;
+		int64 LoadedBytes = 0;
+		GetProgress(Loaded, LoadedBytes);
+
+		FScopedSlowTask SlowTask(Assets.Num() - Loaded, GetProgressText());
+		SlowTask.MakeDialog(true);
+
+		while (!HasCompleted())
+		{
+			ProcessAsyncLoading(true, false, 0.1f);
+
+			const int32 LastLoaded = Loaded;
+			GetProgress(Loaded, LoadedBytes);
+			SlowTask.EnterProgressFrame(Loaded - LastLoaded, GetProgressText());
+
+			if (SlowTask.ShouldCancel())
+			{
+				Cancel();
+				return false;
+			}
+		}
+	}
+
+	CloseNotification(true);
+	return true;
+}
+
+void FRetargetAsyncLoad::OnPreTick(float DeltaTime)
+{
+	if (bCancelled || HasCompleted())
+	{
+		CloseNotification(!bCancelled);
+		return;
+	}
+
+	// Modal windows don't tick the engine. Keep loading while dialogs are open
+	if (FSlateApplication::Get().GetActiveModalWindow().IsValid())
+	{
+		ProcessAsyncLoading(true, false, 0.005f);
+	}
+}
+
+void FRetargetAsyncLoad::CloseNotification(bool bSucceeded)
+{
+	if (FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnPreTick().Remove(PreTickHandle);
+		PreTickHandle.Reset();
+	}
+
+	if (TSharedPtr<SNotificationItem> Item = Notification.Pin())
+	{
+		Item->SetText(GetProgressText());
+		Item->SetCompletionState(bSucceeded ? SNotificationItem::CS_Success : SNotificationItem::CS_None);
+		Item->ExpireAndFadeout();
+	}
+	Notification.Reset();
+}
+
+void FRetargetAsyncLoad::GetProgress(int32& OutLoaded, int64& OutLoadedBytes) const
+{
+	OutLoaded = 0;
+	OutLoadedBytes = 0;
+	for (int32 I = 0; I < Assets.Num(); ++I)
+	{
+		if (Assets[I].IsAssetLoaded())
+		{
+			++OutLoaded;
+			OutLoadedBytes += AssetSizes[I];
+		}
+	}
+}
+
+FText FRetargetAsyncLoad::GetProgressText() const
+{
+	if (bCancelled)
+	{
+		return LOCTEXT("LoadCancelled", "Loading blueprints cancelled");
+	}
+
+	int32 Loaded;
+	int64 LoadedBytes;
+	GetProgress(Loaded, LoadedBytes);
+	return FText::Format(LOCTEXT("LoadProgress", "Loading blueprints {0}/{1} ({2} of {3})"),
+		FText::AsNumber(Loaded), FText::AsNumber(Assets.Num()),
+		FText::AsMemory(LoadedBytes), FText::AsMemory(TotalBytes));
+}
+
+#undef LOCTEXT_NAMESPACE
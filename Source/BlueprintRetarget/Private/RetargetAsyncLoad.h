@@ -0,0 +1,51 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <AssetData.h>
+#include <Templates/SharedPointer.h>
+
+struct FStreamableHandle;
+class SNotificationItem;
+
+
+/**
+ * Loads a set of assets asynchronously, showing progress and allowing to cancel.
+ * Loading keeps going while modal dialogs (E.g: warnings or the class picker) are open.
+ */
+class FRetargetAsyncLoad : public TSharedFromThis<FRetargetAsyncLoad>
+{
+	TArray<FAssetData> Assets;
+	TArray<int64> AssetSizes;
+	int64 TotalBytes = 0;
+
+	TSharedPtr<FStreamableHandle> Handle;
+	TWeakPtr<SNotificationItem> Notification;
+	FDelegateHandle PreTickHandle;
+	bool bCancelled = false;
+
+
+public:
+	FRetargetAsyncLoad(const TArray<FAssetData>& InAssets);
+	~FRetargetAsyncLoad();
+
+	void Start();
+	void Cancel();
+
+	bool IsCancelled() const { return bCancelled; }
+	bool HasCompleted() const;
+
+	/**
+	 * Blocks with a progress dialog until all assets are loaded
+	 * @return false if loading was cancelled
+	 */
+	bool Wait();
+
+private:
+	void OnPreTick(float DeltaTime);
+	void CloseNotification(bool bSucceeded);
+
+	void GetProgress(int32& OutLoaded, int64& OutLoadedBytes) const;
+	FText GetProgressText() const;
+};
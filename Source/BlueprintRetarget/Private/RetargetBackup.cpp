@@ -0,0 +1,228 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetBackup.h"
+#include "BlueprintRetarget.h"
+#include "BrokenBlueprintIndex.h"
+
+#include <AssetRegistryModule.h>
+#include <HAL/FileManager.h>
+#include <Misc/DateTime.h>
+#include <Misc/FileHelper.h>
+#include <Misc/PackageName.h>
+#include <Misc/Paths.h>
+#include <Dom/JsonObject.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonWriter.h>
+#include <Serialization/JsonSerializer.h>
+#include <PackageTools.h>
+#include <UObject/Package.h>
+
+
+static const TCHAR* ManifestName = TEXT("Manifest.json");
+
+
+FRetargetBackup::FRetargetBackup(const FString& InDirectory)
+{
+	if (!InDirectory.IsEmpty())
+	{
+		Directory = InDirectory;
+		return;
+	}
+
+	Directory = GetBackupsRoot() / FDateTime::Now().ToString();
+
+	// Two backups in the same second get different folders
+	for (int32 Suffix = 1; IFileManager::Get().DirectoryExists(*Directory); ++Suffix)
+	{
+		Directory = GetBackupsRoot() / FString::Printf(TEXT("%s_%i"), *FDateTime::Now().ToString(), Suffix);
+	}
+}
+
+bool FRetargetBackup::Add(FName PackageName)
+{
+	const FString Package = PackageName.ToString();
+	if (Files.Contains(Package))
+	{
+		return true;
+	}
+
+	FString Filename;
+	if (!FPackageName::DoesPackageExist(Package, nullptr, &Filename))
+	{
+		// Never saved, nothing to restore
+		return true;
+	}
+	Filename = FPaths::ConvertRelativePathToFull(Filename);
+
+	const FString BackupFilename = Directory / Package + FPaths::GetExtension(Filename, true);
+	if (IFileManager::Get().Copy(*BackupFilename, *Filename, true, true) != COPY_OK)
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't backup '%s' to '%s'"), *Filename, *BackupFilename);
+		return false;
+	}
+
+	Files.Add(Package, Filename);
+	return true;
+}
+
+bool FRetargetBackup::Save() const
+{
+	TSharedRef<FJsonObject> Packages = MakeShared<FJsonObject>();
+	for (const auto& File : Files)
+	{
+		Packages->SetStringField(File.Key, File.Value);
+	}
+
+	TSharedRef<FJsonObject> Manifest = MakeShared<FJsonObject>();
+	Manifest->SetObjectField(TEXT("Packages"), Packages);
+
+	FString ManifestText;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ManifestText);
+	FJsonSerializer::Serialize(Manifest, Writer);
+	if (!FFileHelper::SaveStringToFile(ManifestText, *(Directory / ManifestName)))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't write backup manifest at '%s'"), *Directory);
+		return false;
+	}
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Backed up %i packages to '%s'"), Files.Num(), *Directory);
+	return true;
+}
+
+bool FRetargetBackup::Merge(const FString& OtherDirectory)
+{
+	if (!IFileManager::Get().DirectoryExists(*OtherDirectory))
+	{
+		// Nothing was backed up
+		return true;
+	}
+
+	TMap<FString, FString> OtherFiles;
+	if (!ReadManifest(OtherDirectory, OtherFiles))
+	{
+		return false;
+	}
+
+	bool bMerged = true;
+	for (const auto& File : OtherFiles)
+	{
+		// Keep the oldest copy if both have the package
+		if (Files.Contains(File.Key))
+		{
+			continue;
+		}
+
+		const FString Extension = FPaths::GetExtension(File.Value, true);
+		if (!IFileManager::Get().Move(*(Directory / File.Key + Extension), *(OtherDirectory / File.Key + Extension)))
+		{
+			UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't move backup of '%s' from '%s'"), *File.Key, *OtherDirectory);
+			bMerged = false;
+			continue;
+		}
+		Files.Add(File.Key, File.Value);
+	}
+
+	if (bMerged)
+	{
+		IFileManager::Get().DeleteDirectory(*OtherDirectory, false, true);
+	}
+	return bMerged;
+}
+
+FString FRetargetBackup::FindLatest()
+{
+	TArray<FString> Backups;
+	IFileManager::Get().FindFiles(Backups, *(GetBackupsRoot() / TEXT("*")), false, true);
+
+	// Folder names are dates, so the latest sorts last
+	Backups.Sort();
+	for (int32 I = Backups.Num() - 1; I >= 0; --I)
+	{
+		const FString BackupDirectory = GetBackupsRoot() / Backups[I];
+		if (FPaths::FileExists(BackupDirectory / ManifestName))
+		{
+			return BackupDirectory;
+		}
+	}
+	return {};
+}
+
+int32 FRetargetBackup::Restore(const FString& BackupDirectory)
+{
+	TMap<FString, FString> Packages;
+	if (!ReadManifest(BackupDirectory, Packages))
+	{
+		return 0;
+	}
+
+	TArray<UPackage*> LoadedPackages;
+	TArray<FString> RestoredFiles;
+	for (const auto& Entry : Packages)
+	{
+		const FString& Package = Entry.Key;
+		const FString& Filename = Entry.Value;
+		const FString BackupFilename = BackupDirectory / Package + FPaths::GetExtension(Filename, true);
+		if (IFileManager::Get().Copy(*Filename, *BackupFilename, true, true) != COPY_OK)
+		{
+			UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't restore '%s' from '%s'"), *Filename, *BackupFilename);
+			continue;
+		}
+		RestoredFiles.Add(Filename);
+
+		if (UPackage* LoadedPackage = FindPackage(nullptr, *Package))
+		{
+			LoadedPackages.Add(LoadedPackage);
+		}
+	}
+
+	// Discard changes in memory too
+	if (LoadedPackages.Num() > 0)
+	{
+		FText ErrorMessage;
+		if (!UPackageTools::ReloadPackages(LoadedPackages, ErrorMessage, EReloadPackagesInteractionMode::AssumePositive))
+		{
+			UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't reload restored packages: %s"), *ErrorMessage.ToString());
+		}
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.ScanModifiedAssetFiles(RestoredFiles);
+	for (const auto& Entry : Packages)
+	{
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssetsByPackageName(FName(*Entry.Key), Assets);
+		for (const FAssetData& AssetData : Assets)
+		{
+			FBrokenBlueprintIndex::Get().Refresh(AssetData);
+		}
+	}
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Restored %i packages from '%s'"), RestoredFiles.Num(), *BackupDirectory);
+	return RestoredFiles.Num();
+}
+
+bool FRetargetBackup::ReadManifest(const FString& BackupDirectory, TMap<FString, FString>& OutFiles)
+{
+	FString ManifestText;
+	FFileHelper::LoadFileToString(ManifestText, *(BackupDirectory / ManifestName));
+
+	TSharedPtr<FJsonObject> Manifest;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ManifestText);
+	const TSharedPtr<FJsonObject>* Packages;
+	if (!FJsonSerializer::Deserialize(Reader, Manifest) || !Manifest.IsValid() || !Manifest->TryGetObjectField(TEXT("Packages"), Packages))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't read backup manifest at '%s'"), *BackupDirectory);
+		return false;
+	}
+
+	for (const auto& Entry : (*Packages)->Values)
+	{
+		OutFiles.Add(Entry.Key, Entry.Value->AsString());
+	}
+	return true;
+}
+
+FString FRetargetBackup::GetBackupsRoot()
+{
+	return FPaths::ProjectSavedDir() / TEXT("BlueprintRetarget") / TEXT("Backups");
+}
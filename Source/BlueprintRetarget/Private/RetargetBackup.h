@@ -0,0 +1,50 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+/**
+ * Copies of package files taken before retargeting them without an undo transaction.
+ * Each backup gets its own folder under Saved/BlueprintRetarget/Backups with a manifest of the copied packages.
+ */
+class FRetargetBackup
+{
+	FString Directory;
+
+	/** Package name -> Original package file */
+	TMap<FString, FString> Files;
+
+
+public:
+	/** Prepares a new, empty backup folder. A new timestamped folder is used if none is provided */
+	FRetargetBackup(const FString& InDirectory = {});
+
+	/** Copies the file of a package into the backup. @return true if copied */
+	bool Add(FName PackageName);
+
+	/** Writes the manifest. Must be called once all packages are added */
+	bool Save() const;
+
+	/** Moves the packages of another backup (E.g: made by a worker process) into this one, and deletes it */
+	bool Merge(const FString& OtherDirectory);
+
+	int32 Num() const { return Files.Num(); }
+	const FString& GetDirectory() const { return Directory; }
+
+	/** @return the folder of the most recent backup, or empty if there is none */
+	static FString FindLatest();
+
+	/**
+	 * Copies the files of a backup over the originals and reloads their packages if they are loaded.
+	 * @return number of packages restored
+	 */
+	static int32 Restore(const FString& BackupDirectory);
+
+	static FString GetBackupsRoot();
+
+private:
+	/** Reads package name -> original file pairs of a backup */
+	static bool ReadManifest(const FString& BackupDirectory, TMap<FString, FString>& OutFiles);
+};
@@ -0,0 +1,338 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetBlueprintFilter.h"
+#include "RetargetUtils.h"
+
+#include <AssetData.h>
+#include <AssetRegistryModule.h>
+#include <UObject/UObjectGlobals.h>
+#include <UObject/UObjectIterator.h>
+#include <Engine/Blueprint.h>
+#include <GameFramework/Actor.h>
+#include <Components/ActorComponent.h>
+#include <Animation/AnimBlueprint.h>
+#include <Animation/AnimInstance.h>
+#include <Engine/LevelScriptActor.h>
+
+
+/** Type of a set of blueprints, as far as reparenting rules are concerned */
+struct FBlueprintKind
+{
+	bool bHasParent = true;
+	bool bIsActor = false;
+	bool bIsAnimBlueprint = false;
+	bool bIsLevelScriptActor = false;
+	bool bIsComponentBlueprint = false;
+
+
+	/** Only registry tags are used so that assets can still be loading */
+	void Add(const FAssetData& AssetData)
+	{
+		const UClass* AssetClass = AssetData.GetClass();
+		bIsAnimBlueprint |= AssetClass && AssetClass->IsChildOf(UAnimBlueprint::StaticClass());
+
+		const UClass* ParentClass = FRetargetUtils::FindLoadedClassFromTag(AssetData, FBlueprintTags::ParentClassPath);
+		bHasParent &= ParentClass != nullptr;
+		if (!ParentClass)
+		{
+			// A missing parent blueprint still tells its type through its native base
+			ParentClass = FRetargetUtils::FindLoadedClassFromTag(AssetData, FBlueprintTags::NativeParentClassPath);
+		}
+
+		if (ParentClass)
+		{
+			bIsActor |= ParentClass->IsChildOf(AActor::StaticClass());
+			bIsLevelScriptActor |= ParentClass->IsChildOf(ALevelScriptActor::StaticClass());
+			bIsComponentBlueprint |= ParentClass->IsChildOf(UActorComponent::StaticClass());
+		}
+	}
+};
+
+
+/** Eligibility shared by every filter. Unloaded classes only change with the asset registry, loaded ones with garbage collection */
+struct FSharedEligibility
+{
+	/** Filter settings key -> Eligibility of unloaded blueprint classes, by class path */
+	TMap<FString, TMap<FName, bool>> UnloadedClasses;
+
+	/** Incremented after every garbage collection */
+	uint32 NumGarbageCollections = 0;
+
+	bool bBound = false;
+
+
+	/** @param bBind starts listening to changes if it wasn't yet */
+	static FSharedEligibility& Get(bool bBind = true)
+	{
+		static FSharedEligibility Instance;
+		if (bBind && !Instance.bBound)
+		{
+			Instance.Bind();
+		}
+		return Instance;
+	}
+
+	void Bind()
+	{
+		bBound = true;
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		AssetRegistry.OnAssetAdded().AddRaw(this, &FSharedEligibility::OnAssetChanged);
+		AssetRegistry.OnAssetRemoved().AddRaw(this, &FSharedEligibility::OnAssetChanged);
+		AssetRegistry.OnAssetRenamed().AddRaw(this, &FSharedEligibility::OnAssetRenamed);
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FSharedEligibility::OnPostGarbageCollect);
+	}
+
+	void Unbind()
+	{
+		if (!bBound)
+		{
+			return;
+		}
+		bBound = false;
+		UnloadedClasses.Reset();
+
+		if (FAssetRegistryModule* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>(TEXT("AssetRegistry")))
+		{
+			IAssetRegistry& AssetRegistry = AssetRegistryModule->Get();
+			AssetRegistry.OnAssetAdded().RemoveAll(this);
+			AssetRegistry.OnAssetRemoved().RemoveAll(this);
+			AssetRegistry.OnAssetRenamed().RemoveAll(this);
+		}
+		FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+	}
+
+	void OnAssetChanged(const FAssetData& AssetData) { UnloadedClasses.Reset(); }
+	void OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath) { UnloadedClasses.Reset(); }
+	void OnPostGarbageCollect() { ++NumGarbageCollections; }
+};
+
+
+TSharedRef<FRetargetBlueprintFilter> FRetargetBlueprintFilter::Create(const TArray<FAssetData>& Assets)
+{
+	// Gather BP information from every asset. Mixed types get the rules of all of them
+	TArray<const UClass*> BlueprintClasses{};
+	FBlueprintKind Kind;
+	for (const FAssetData& AssetData : Assets)
+	{
+		Kind.Add(AssetData);
+		if (const UClass* GeneratedClass = FRetargetUtils::FindLoadedClassFromTag(AssetData, FBlueprintTags::GeneratedClassPath))
+		{
+			BlueprintClasses.Add(GeneratedClass);
+		}
+	}
+
+
+	TSharedRef<FRetargetBlueprintFilter> Filter = MakeShared<FRetargetBlueprintFilter>();
+
+	Filter->DisallowedChildrenOfClasses.Add(UInterface::StaticClass());
+	Filter->DisallowedChildrenOfClasses.Append(BlueprintClasses); // Can't re-parent to child BPs
+	for (const FAssetData& AssetData : Assets)
+	{
+		// Rules depend on the blueprint type. Use the loaded blueprint if any, its type default otherwise
+		const UBlueprint* BP = AssetData.IsAssetLoaded() ? Cast<UBlueprint>(AssetData.FastGetAsset(false)) : nullptr;
+		if (!BP && AssetData.GetClass())
+		{
+			BP = Cast<UBlueprint>(AssetData.GetClass()->GetDefaultObject());
+		}
+		if (BP)
+		{
+			BP->GetReparentingRules(Filter->AllowedChildrenOfClasses, Filter->DisallowedChildrenOfClasses);
+		}
+	}
+
+	if (Kind.bIsActor)
+	{
+		if (Kind.bIsLevelScriptActor)
+		{
+			// Don't allow conversion outside of the LevelScriptActor hierarchy
+			Filter->AllowedChildrenOfClasses.Add(ALevelScriptActor::StaticClass());
+			Filter->bShowNativeOnly = true;
+		}
+		else
+		{
+			// Don't allow conversion outside of the Actor hierarchy
+			Filter->AllowedChildrenOfClasses.Add(AActor::StaticClass());
+
+			// Don't allow non-LevelScriptActor->LevelScriptActor conversion
+			Filter->DisallowedChildrenOfClasses.Add(ALevelScriptActor::StaticClass());
+		}
+	}
+	else if (Kind.bIsAnimBlueprint)
+	{
+		// If it's an anim blueprint, do not allow conversion to non anim
+		Filter->AllowedChildrenOfClasses.Add(UAnimInstance::StaticClass());
+	}
+	else if (Kind.bIsComponentBlueprint)
+	{
+		// If it is a component blueprint, only allow classes under and including UActorComponent
+		Filter->AllowedChildrenOfClasses.Add(UActorComponent::StaticClass());
+	}
+	else if (Kind.bHasParent)
+	{
+		Filter->DisallowedChildrenOfClasses.Add(AActor::StaticClass());
+	}
+
+	for (const FAssetData& AssetData : Assets)
+	{
+		// don't allow making me my own parent!
+		if (const UClass* GeneratedClass = FRetargetUtils::FindLoadedClassFromTag(AssetData, FBlueprintTags::GeneratedClassPath))
+		{
+			Filter->DisallowedClasses.Add(GeneratedClass);
+		}
+	}
+
+	Filter->PrepareEligibility();
+	return Filter;
+}
+
+FString FRetargetBlueprintFilter::GetGroupKey(const FAssetData& AssetData)
+{
+	FBlueprintKind Kind;
+	Kind.Add(AssetData);
+
+	FString MissingParentPath = FRetargetUtils::FindUnresolvedParentPath(AssetData);
+	if (MissingParentPath.IsEmpty())
+	{
+		MissingParentPath = FRetargetUtils::GetParentClassPath(AssetData);
+	}
+
+	// Blueprint type decides the reparenting rules, the rest decide the filter
+	return FString::Printf(TEXT("%s %i%i%i%i%i %s"), *AssetData.AssetClass.ToString(),
+		Kind.bHasParent, Kind.bIsActor, Kind.bIsAnimBlueprint, Kind.bIsLevelScriptActor, Kind.bIsComponentBlueprint, *MissingParentPath);
+}
+
+TArray<TArray<FAssetData>> FRetargetBlueprintFilter::GroupByKind(const TArray<FAssetData>& Assets)
+{
+	TArray<TArray<FAssetData>> Groups;
+	TMap<FString, int32> GroupIndices;
+	for (const FAssetData& AssetData : Assets)
+	{
+		const FString Key = GetGroupKey(AssetData);
+		int32* GroupIndex = GroupIndices.Find(Key);
+		if (!GroupIndex)
+		{
+			GroupIndex = &GroupIndices.Add(Key, Groups.AddDefaulted());
+		}
+		Groups[*GroupIndex].Add(AssetData);
+	}
+	return Groups;
+}
+
+void FRetargetBlueprintFilter::PrepareEligibility()
+{
+	SettingsKey = MakeSettingsKey();
+	EvaluatedGarbageCollections = FSharedEligibility::Get().NumGarbageCollections;
+
+	EvaluatedClasses.Reset();
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		EvaluatedClasses.Add(*It, EvaluateClass(*It));
+	}
+}
+
+bool FRetargetBlueprintFilter::IsClassAllowed(const FClassViewerInitializationOptions& InInitOptions, const UClass* InClass, TSharedRef< FClassViewerFilterFuncs > InFilterFuncs)
+{
+	return IsClassEligible(InClass);
+}
+
+bool FRetargetBlueprintFilter::IsClassEligible(const UClass* InClass)
+{
+	const uint32 NumGarbageCollections = FSharedEligibility::Get().NumGarbageCollections;
+	if (EvaluatedGarbageCollections != NumGarbageCollections)
+	{
+		// Classes evaluated before may have been destroyed. They get evaluated again as they are asked for
+		EvaluatedClasses.Reset();
+		EvaluatedGarbageCollections = NumGarbageCollections;
+	}
+
+	if (const bool* bCachedAllowed = EvaluatedClasses.Find(InClass))
+	{
+		return *bCachedAllowed;
+	}
+
+	// Class was loaded after the filter got prepared
+	const bool bAllowed = EvaluateClass(InClass);
+	EvaluatedClasses.Add(InClass, bAllowed);
+	return bAllowed;
+}
+
+bool FRetargetBlueprintFilter::IsUnloadedClassAllowed(const FClassViewerInitializationOptions& InInitOptions, const TSharedRef< const IUnloadedBlueprintData > InUnloadedClassData, TSharedRef< FClassViewerFilterFuncs > InFilterFuncs)
+{
+	const FName ClassPath = InUnloadedClassData->GetClassPath();
+	TMap<FName, bool>& AllowedUnloadedClasses = FSharedEligibility::Get().UnloadedClasses.FindOrAdd(SettingsKey);
+	if (const bool* bCachedAllowed = AllowedUnloadedClasses.Find(ClassPath))
+	{
+		return *bCachedAllowed;
+	}
+
+	// If it appears on the allowed child-of classes list (or there is nothing on that list)
+	//		AND it is NOT on the disallowed child-of classes list
+	//		AND it is NOT on the disallowed classes list
+	const bool bAllowed = InFilterFuncs->IfInChildOfClassesSet(AllowedChildrenOfClasses, InUnloadedClassData) != EFilterReturn::Failed &&
+		InFilterFuncs->IfInChildOfClassesSet(DisallowedChildrenOfClasses, InUnloadedClassData) != EFilterReturn::Passed &&
+		InFilterFuncs->IfInClassesSet(DisallowedClasses, InUnloadedClassData) != EFilterReturn::Passed &&
+		!InUnloadedClassData->HasAnyClassFlags(CLASS_Deprecated) &&
+		((bShowNativeOnly && InUnloadedClassData->HasAnyClassFlags(CLASS_Native)) || !bShowNativeOnly);
+
+	AllowedUnloadedClasses.Add(ClassPath, bAllowed);
+	return bAllowed;
+}
+
+bool FRetargetBlueprintFilter::EvaluateClass(const UClass* InClass) const
+{
+	if (InClass->HasAnyClassFlags(CLASS_Deprecated) || (bShowNativeOnly && !InClass->HasAnyClassFlags(CLASS_Native)))
+	{
+		return false;
+	}
+
+	if (DisallowedClasses.Contains(InClass))
+	{
+		return false;
+	}
+
+	for (const UClass* DisallowedParent : DisallowedChildrenOfClasses)
+	{
+		if (InClass->IsChildOf(DisallowedParent))
+		{
+			return false;
+		}
+	}
+
+	// It must appear on the allowed child-of classes list (or there is nothing on that list)
+	if (AllowedChildrenOfClasses.Num() <= 0)
+	{
+		return true;
+	}
+	for (const UClass* AllowedParent : AllowedChildrenOfClasses)
+	{
+		if (InClass->IsChildOf(AllowedParent))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+FString FRetargetBlueprintFilter::MakeSettingsKey() const
+{
+	auto AppendClasses = [](FString& Key, const TSet<const UClass*>& Classes) {
+		TArray<FString> Paths;
+		for (const UClass* Class : Classes)
+		{
+			Paths.Add(Class->GetPathName());
+		}
+		Paths.Sort();
+		Key += FString::Join(Paths, TEXT(",")) + TEXT(";");
+	};
+
+	FString Key = bShowNativeOnly ? TEXT("Native;") : TEXT("All;");
+	AppendClasses(Key, AllowedChildrenOfClasses);
+	AppendClasses(Key, DisallowedChildrenOfClasses);
+	AppendClasses(Key, DisallowedClasses);
+	return Key;
+}
+
+void FRetargetBlueprintFilter::ReleaseSharedCache()
+{
+	FSharedEligibility::Get(false).Unbind();
+}
@@ -0,0 +1,68 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <ClassViewerFilter.h>
+
+struct FAssetData;
+
+
+class FRetargetBlueprintFilter : public IClassViewerFilter
+{
+public:
+	/** All children of these classes will be included unless filtered out by another setting. */
+	TSet< const UClass* > AllowedChildrenOfClasses;
+
+	/** Classes to not allow any children of into the Class Viewer/Picker. */
+	TSet< const UClass* > DisallowedChildrenOfClasses;
+
+	/** Classes to never show in this class viewer. */
+	TSet< const UClass* > DisallowedClasses;
+
+	/** Will limit the results to only native classes */
+	bool bShowNativeOnly;
+
+private:
+	/** Eligibility of loaded classes. A destroyed class address can be reused, so it is dropped after garbage collection */
+	TMap<const UClass*, bool> EvaluatedClasses;
+	uint32 EvaluatedGarbageCollections = 0;
+
+	/** Identifies the filter settings. Filters with the same settings share the eligibility of unloaded classes */
+	FString SettingsKey;
+
+
+public:
+	FRetargetBlueprintFilter()
+		: bShowNativeOnly(false)
+	{}
+
+	/** Creates a filter of valid parent classes for a set of blueprints, from their registry tags */
+	static TSharedRef<FRetargetBlueprintFilter> Create(const TArray<FAssetData>& Assets);
+
+	/** @return a key shared by blueprints that accept the same parents: same type, reparenting rules and missing parent */
+	static FString GetGroupKey(const FAssetData& AssetData);
+
+	/** Splits blueprints in groups that can be retargeted to the same parent, keeping their order */
+	static TArray<TArray<FAssetData>> GroupByKind(const TArray<FAssetData>& Assets);
+
+	/**
+	 * Evaluates every loaded class once so that the picker only needs a lookup per class.
+	 * Must be called after filter settings are assigned.
+	 */
+	void PrepareEligibility();
+
+	/** @return true if a loaded class is a valid parent. Not thread-safe */
+	bool IsClassEligible(const UClass* InClass);
+
+	virtual bool IsClassAllowed(const FClassViewerInitializationOptions& InInitOptions, const UClass* InClass, TSharedRef< FClassViewerFilterFuncs > InFilterFuncs) override;
+
+	virtual bool IsUnloadedClassAllowed(const FClassViewerInitializationOptions& InInitOptions, const TSharedRef< const IUnloadedBlueprintData > InUnloadedClassData, TSharedRef< FClassViewerFilterFuncs > InFilterFuncs) override;
+
+	/** Stops listening to the asset registry and garbage collection. Called when the module shuts down */
+	static void ReleaseSharedCache();
+
+private:
+	bool EvaluateClass(const UClass* InClass) const;
+	FString MakeSettingsKey() const;
+};
@@ -0,0 +1,260 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetCompatibility.h"
+#include "RetargetSuggestions.h"
+
+#include <Async/ParallelFor.h>
+#include <Engine/Blueprint.h>
+#include <Engine/SCS_Node.h>
+#include <Engine/SimpleConstructionScript.h>
+#include <EdGraph/EdGraph.h>
+#include <GameFramework/Actor.h>
+#include <K2Node_CallFunction.h>
+#include <K2Node_CallParentFunction.h>
+#include <K2Node_Event.h>
+#include <K2Node_FunctionEntry.h>
+#include <K2Node_Variable.h>
+#include <K2Node_VariableSet.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+
+
+FString FRetargetIssue::ToString() const
+{
+	const FString Name = Member.ToString();
+	FString Description;
+	switch (Type)
+	{
+	case ERetargetIssue::MissingFunction:
+		Description = FString::Printf(TEXT("calls missing function '%s'"), *Name);
+		break;
+	case ERetargetIssue::NotCallable:
+		Description = FString::Printf(TEXT("calls '%s', which is not callable from blueprints"), *Name);
+		break;
+	case ERetargetIssue::MissingEvent:
+		Description = FString::Printf(TEXT("overrides missing function or event '%s'"), *Name);
+		break;
+	case ERetargetIssue::NotOverridable:
+		Description = FString::Printf(TEXT("overrides '%s', which can't be overridden from blueprints"), *Name);
+		break;
+	case ERetargetIssue::MissingVariable:
+		Description = FString::Printf(TEXT("uses missing variable '%s'"), *Name);
+		break;
+	case ERetargetIssue::NotAccessible:
+		Description = FString::Printf(TEXT("uses '%s', which is not visible to blueprints"), *Name);
+		break;
+	case ERetargetIssue::ReadOnlyVariable:
+		Description = FString::Printf(TEXT("sets read only variable '%s'"), *Name);
+		break;
+	case ERetargetIssue::MissingAttachParent:
+		Description = FString::Printf(TEXT("attaches components to missing component '%s'"), *Name);
+		break;
+	case ERetargetIssue::ComponentsNotSupported:
+		Description = TEXT("has components, but the new parent is not an actor");
+		break;
+	case ERetargetIssue::DuplicatedInterface:
+		Description = FString::Printf(TEXT("implements '%s', which the new parent already implements"), *Name);
+		break;
+	}
+
+	if (!Graph.IsNone())
+	{
+		return FString::Printf(TEXT("%s: %s"), *Graph.ToString(), *Description);
+	}
+	return Description;
+}
+
+FString FRetargetCompatibilityReport::ToString() const
+{
+	FString Text = FString::Printf(TEXT("%s -> %s: %i issues"),
+		Blueprint.IsValid() ? *Blueprint->GetName() : TEXT("None"),
+		Class.IsValid() ? *Class->GetName() : TEXT("None"),
+		Issues.Num());
+
+	for (const FRetargetIssue& Issue : Issues)
+	{
+		Text += TEXT("\n  ") + Issue.ToString();
+	}
+	return Text;
+}
+
+
+FRetargetCompatibilityReport FRetargetCompatibility::Analyze(const UBlueprint* Blueprint, const UClass* Class)
+{
+	FRetargetCompatibilityReport Report;
+	Report.Blueprint = Blueprint;
+	Report.Class = Class;
+	if (!Blueprint || !Class)
+	{
+		return Report;
+	}
+
+	auto AddIssue = [&Report](ERetargetIssue Type, FName Member, const UEdGraphNode* Node = nullptr) {
+		FRetargetIssue& Issue = Report.Issues.AddDefaulted_GetRef();
+		Issue.Type = Type;
+		Issue.Member = Member;
+		Issue.Node = Node;
+		if (Node && Node->GetGraph())
+		{
+			Issue.Graph = Node->GetGraph()->GetFName();
+		}
+	};
+
+	auto CheckOverride = [&](FName Name, const UEdGraphNode* Node) {
+		const UFunction* Function = Class->FindFunctionByName(Name);
+		if (!Function)
+		{
+			AddIssue(ERetargetIssue::MissingEvent, Name, Node);
+		}
+		else if (!Function->HasAnyFunctionFlags(FUNC_BlueprintEvent))
+		{
+			AddIssue(ERetargetIssue::NotOverridable, Name, Node);
+		}
+	};
+
+	TSet<FName> OwnMembers;
+	FParentMemberUsage::GatherOwnMembers(Blueprint, OwnMembers);
+
+	TArray<UEdGraph*> Graphs;
+	Blueprint->GetAllGraphs(Graphs);
+	for (const UEdGraph* Graph : Graphs)
+	{
+		if (!Graph)
+		{
+			continue;
+		}
+
+		for (const UEdGraphNode* Node : Graph->Nodes)
+		{
+			if (const UK2Node_Event* Event = Cast<UK2Node_Event>(Node))
+			{
+				const FName Name = Event->EventReference.GetMemberName();
+				if (Event->bOverrideFunction && !OwnMembers.Contains(Name))
+				{
+					CheckOverride(Name, Node);
+				}
+			}
+			else if (const UK2Node_FunctionEntry* Entry = Cast<UK2Node_FunctionEntry>(Node))
+			{
+				// Entries of overridden functions reference the parent, new functions reference self
+				const FName Name = Entry->FunctionReference.GetMemberName();
+				if (!Entry->FunctionReference.IsSelfContext() && Graph->GetFName() == Name)
+				{
+					CheckOverride(Name, Node);
+				}
+			}
+			else if (const UK2Node_CallFunction* Call = Cast<UK2Node_CallFunction>(Node))
+			{
+				const FName Name = Call->FunctionReference.GetMemberName();
+				const bool bParentCall = Node->IsA<UK2Node_CallParentFunction>();
+				if (!bParentCall && (!Call->FunctionReference.IsSelfContext() || OwnMembers.Contains(Name)))
+				{
+					continue;
+				}
+
+				const UFunction* Function = Class->FindFunctionByName(Name);
+				if (!Function)
+				{
+					AddIssue(ERetargetIssue::MissingFunction, Name, Node);
+				}
+				else if (!bParentCall && !Function->HasAnyFunctionFlags(FUNC_BlueprintCallable | FUNC_BlueprintPure | FUNC_BlueprintEvent))
+				{
+					AddIssue(ERetargetIssue::NotCallable, Name, Node);
+				}
+			}
+			else if (const UK2Node_Variable* Variable = Cast<UK2Node_Variable>(Node))
+			{
+				const FName Name = Variable->VariableReference.GetMemberName();
+				if (!Variable->VariableReference.IsSelfContext() || OwnMembers.Contains(Name))
+				{
+					continue;
+				}
+
+				const FProperty* Property = Class->FindPropertyByName(Name);
+				if (!Property)
+				{
+					AddIssue(ERetargetIssue::MissingVariable, Name, Node);
+				}
+				else if (!Property->HasAnyPropertyFlags(CPF_BlueprintVisible))
+				{
+					AddIssue(ERetargetIssue::NotAccessible, Name, Node);
+				}
+				else if (Node->IsA<UK2Node_VariableSet>() && Property->HasAnyPropertyFlags(CPF_BlueprintReadOnly))
+				{
+					AddIssue(ERetargetIssue::ReadOnlyVariable, Name, Node);
+				}
+			}
+		}
+	}
+
+	if (const USimpleConstructionScript* SCS = Blueprint->SimpleConstructionScript)
+	{
+		const TArray<USCS_Node*>& Components = SCS->GetAllNodes();
+		if (Components.Num() > 0 && !Class->IsChildOf(AActor::StaticClass()))
+		{
+			AddIssue(ERetargetIssue::ComponentsNotSupported, NAME_None);
+		}
+		else
+		{
+			// Components attached to an inherited component need it on the new parent
+			for (const USCS_Node* Component : Components)
+			{
+				if (Component && Component->ParentComponentOwnerClassName != NAME_None &&
+					!Class->FindPropertyByName(Component->ParentComponentOrVariableName))
+				{
+					AddIssue(ERetargetIssue::MissingAttachParent, Component->ParentComponentOrVariableName);
+				}
+			}
+		}
+	}
+
+	for (const FBPInterfaceDescription& Interface : Blueprint->ImplementedInterfaces)
+	{
+		if (Interface.Interface && Class->ImplementsInterface(Interface.Interface))
+		{
+			AddIssue(ERetargetIssue::DuplicatedInterface, Interface.Interface->GetFName());
+		}
+	}
+	return Report;
+}
+
+TArray<FRetargetCompatibilityReport> FRetargetCompatibility::Analyze(const TArray<TPair<UBlueprint*, UClass*>>& Reparents)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BlueprintRetarget_Analyze);
+
+	// Analysis only reads reflection data and graphs, so blueprints are independent
+	TArray<FRetargetCompatibilityReport> Reports;
+	Reports.SetNum(Reparents.Num());
+	ParallelFor(Reparents.Num(), [&Reports, &Reparents](int32 Index) {
+		Reports[Index] = Analyze(Reparents[Index].Key, Reparents[Index].Value);
+	});
+	return Reports;
+}
+
+FString FRetargetCompatibility::Describe(const TArray<FRetargetCompatibilityReport>& Reports, int32 MaxIssues)
+{
+	FString Text;
+	int32 NumIssues = 0;
+	int32 NumHidden = 0;
+	for (const FRetargetCompatibilityReport& Report : Reports)
+	{
+		if (Report.IsCompatible())
+		{
+			continue;
+		}
+
+		if (NumIssues >= MaxIssues)
+		{
+			NumHidden += Report.Issues.Num();
+			continue;
+		}
+
+		Text += Report.ToString() + TEXT("\n");
+		NumIssues += Report.Issues.Num();
+	}
+
+	if (NumHidden > 0)
+	{
+		Text += FString::Printf(TEXT("...and %i more issues\n"), NumHidden);
+	}
+	return Text;
+}
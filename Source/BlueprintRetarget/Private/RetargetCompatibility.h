@@ -0,0 +1,73 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <UObject/WeakObjectPtrTemplates.h>
+
+class UBlueprint;
+class UClass;
+class UEdGraphNode;
+
+
+enum class ERetargetIssue : uint8
+{
+	MissingFunction,
+	NotCallable,
+	MissingEvent,
+	NotOverridable,
+	MissingVariable,
+	NotAccessible,
+	ReadOnlyVariable,
+	MissingAttachParent,
+	ComponentsNotSupported,
+	DuplicatedInterface
+};
+
+
+/** Something a blueprint uses from its parent that the new parent doesn't provide */
+struct FRetargetIssue
+{
+	ERetargetIssue Type;
+	FName Member;
+
+	/** Node that will break, if any */
+	TWeakObjectPtr<const UEdGraphNode> Node;
+	FName Graph;
+
+
+	FString ToString() const;
+};
+
+
+struct FRetargetCompatibilityReport
+{
+	TWeakObjectPtr<const UBlueprint> Blueprint;
+	TWeakObjectPtr<const UClass> Class;
+	TArray<FRetargetIssue> Issues;
+
+
+	bool IsCompatible() const { return Issues.Num() <= 0; }
+
+	FString ToString() const;
+};
+
+
+/**
+ * Predicts which nodes of a blueprint would break with a new parent, without modifying or compiling it.
+ * Checks parent function calls, overridden events and functions, inherited variables, components attached
+ * to inherited components and implemented interfaces against the reflection data of the new parent.
+ */
+struct FRetargetCompatibility
+{
+	static FRetargetCompatibilityReport Analyze(const UBlueprint* Blueprint, const UClass* Class);
+
+	/**
+	 * Analyzes many blueprints in parallel. Blueprints and classes must not change meanwhile.
+	 * @return a report for each blueprint and its new parent
+	 */
+	static TArray<FRetargetCompatibilityReport> Analyze(const TArray<TPair<UBlueprint*, UClass*>>& Reparents);
+
+	/** @return a description of all incompatible reports, for logs and dialogs */
+	static FString Describe(const TArray<FRetargetCompatibilityReport>& Reports, int32 MaxIssues = 50);
+};
@@ -0,0 +1,226 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetHierarchy.h"
+#include "RetargetUtils.h"
+#include "RetargetStats.h"
+
+#include <Engine/Blueprint.h>
+#include <Misc/PackageName.h>
+
+
+FRetargetHierarchy::FRetargetHierarchy(const TArray<FAssetData>& Assets)
+{
+	// Index blueprints by the class they generate
+	TMap<FName, int32> NodesByClass;
+	for (const FAssetData& AssetData : Assets)
+	{
+		if (!FRetargetUtils::IsBlueprintAsset(AssetData))
+		{
+			continue;
+		}
+
+		FString GeneratedClassPath;
+		if (AssetData.GetTagValue(FBlueprintTags::GeneratedClassPath, GeneratedClassPath))
+		{
+			GeneratedClassPath = FPackageName::ExportTextPathToObjectPath(GeneratedClassPath);
+		}
+		else
+		{
+			GeneratedClassPath = AssetData.ObjectPath.ToString() + TEXT("_C");
+		}
+
+		const int32 Index = Nodes.AddDefaulted();
+		Nodes[Index].AssetData = AssetData;
+		NodesByClass.Add(FName(*GeneratedClassPath), Index);
+	}
+
+	// Link children to their parents
+	for (int32 Index = 0; Index < Nodes.Num(); ++Index)
+	{
+		FNode& Node = Nodes[Index];
+		const FString ParentClassPath = FRetargetUtils::GetParentClassPath(Node.AssetData);
+		const int32* ParentIndex = ParentClassPath.IsEmpty() ? nullptr : NodesByClass.Find(FName(*ParentClassPath));
+		if (ParentIndex && *ParentIndex != Index)
+		{
+			Node.Parent = *ParentIndex;
+			Nodes[*ParentIndex].Children.Add(Index);
+		}
+		else
+		{
+			Roots.Add(Index);
+		}
+	}
+
+	// Each root starts an independent subtree. Walk it parents first
+	auto WalkSubtree = [this](int32 Root) {
+		const int32 BatchIndex = Batches.AddDefaulted();
+		TArray<int32>& Batch = Batches[BatchIndex];
+		Batch.Add(Root);
+		for (int32 I = 0; I < Batch.Num(); ++I)
+		{
+			FNode& Node = Nodes[Batch[I]];
+			Node.Batch = BatchIndex;
+			for (int32 Child : Node.Children)
+			{
+				Nodes[Child].Depth = Node.Depth + 1;
+				Batch.Add(Child);
+			}
+		}
+		Order.Append(Batch);
+	};
+
+	Order.Reserve(Nodes.Num());
+	for (int32 Root : Roots)
+	{
+		WalkSubtree(Root);
+	}
+
+	// Nodes in a parent cycle are never reached from a root. Break the cycle
+	for (int32 Index = 0; Index < Nodes.Num(); ++Index)
+	{
+		FNode& Node = Nodes[Index];
+		if (Node.Batch == INDEX_NONE)
+		{
+			Nodes[Node.Parent].Children.Remove(Index);
+			Node.Parent = INDEX_NONE;
+			Roots.Add(Index);
+			WalkSubtree(Index);
+		}
+	}
+
+	Order.StableSort([this](int32 A, int32 B) {
+		return Nodes[A].Depth < Nodes[B].Depth;
+	});
+}
+
+int32 FRetargetHierarchy::GetMaxDepth() const
+{
+	int32 MaxDepth = 0;
+	for (const FNode& Node : Nodes)
+	{
+		MaxDepth = FMath::Max(MaxDepth, Node.Depth);
+	}
+	return MaxDepth;
+}
+
+TArray<TArray<FAssetData>> FRetargetHierarchy::SplitByMemory(int64 MemoryBudget, const TArray<FName>& IsolatedPackages) const
+{
+	const TArray<int64> BatchSizes = GetBatchSizes();
+
+	TArray<TArray<FAssetData>> Chunks;
+	for (const TArray<int32>& ChunkBatches : FRetargetUtils::SplitByBudget(BatchSizes, MemoryBudget))
+	{
+		TArray<int32> ChunkNodes;
+		bool bHasIsolated = false;
+		for (int32 BatchIndex : ChunkBatches)
+		{
+			for (int32 Index : Batches[BatchIndex])
+			{
+				ChunkNodes.Add(Index);
+				bHasIsolated |= IsolatedPackages.Contains(Nodes[Index].AssetData.PackageName);
+			}
+		}
+
+		if (!bHasIsolated)
+		{
+			TArray<FAssetData>& Chunk = Chunks.AddDefaulted_GetRef();
+			for (int32 Index : ChunkNodes)
+			{
+				Chunk.Add(Nodes[Index].AssetData);
+			}
+			continue;
+		}
+
+		// Isolated blueprints go alone. The rest of the chunk is split by depth level, so parents still go before their children
+		ChunkNodes.StableSort([this](int32 A, int32 B) {
+			return Nodes[A].Depth < Nodes[B].Depth;
+		});
+		int32 LevelChunk = INDEX_NONE;
+		int32 LevelDepth = INDEX_NONE;
+		for (int32 Index : ChunkNodes)
+		{
+			const FNode& Node = Nodes[Index];
+			if (IsolatedPackages.Contains(Node.AssetData.PackageName))
+			{
+				Chunks.Add({ Node.AssetData });
+				continue;
+			}
+
+			if (Node.Depth != LevelDepth)
+			{
+				LevelChunk = Chunks.AddDefaulted();
+				LevelDepth = Node.Depth;
+			}
+			Chunks[LevelChunk].Add(Node.AssetData);
+		}
+	}
+	return Chunks;
+}
+
+TArray<TArray<FAssetData>> FRetargetHierarchy::SplitInShards(int32 NumShards) const
+{
+	TArray<TArray<FAssetData>> Shards;
+	Shards.SetNum(FMath::Clamp(NumShards, 1, FMath::Max(1, Batches.Num())));
+	TArray<int64> ShardSizes;
+	ShardSizes.SetNumZeroed(Shards.Num());
+
+	// Biggest subtrees first, each one to the least loaded shard
+	const TArray<int64> BatchSizes = GetBatchSizes();
+	TArray<int32> SortedBatches;
+	for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+	{
+		SortedBatches.Add(BatchIndex);
+	}
+	SortedBatches.Sort([&BatchSizes](int32 A, int32 B) {
+		return BatchSizes[A] > BatchSizes[B];
+	});
+
+	for (int32 BatchIndex : SortedBatches)
+	{
+		int32 Shard = 0;
+		for (int32 I = 1; I < ShardSizes.Num(); ++I)
+		{
+			if (ShardSizes[I] < ShardSizes[Shard])
+			{
+				Shard = I;
+			}
+		}
+
+		// Blueprints without a known size still count
+		ShardSizes[Shard] += FMath::Max<int64>(BatchSizes[BatchIndex], Batches[BatchIndex].Num());
+		for (int32 Index : Batches[BatchIndex])
+		{
+			Shards[Shard].Add(Nodes[Index].AssetData);
+		}
+	}
+	return Shards;
+}
+
+TArray<int64> FRetargetHierarchy::GetBatchSizes() const
+{
+	TArray<int64> BatchSizes;
+	BatchSizes.Reserve(Batches.Num());
+	for (const TArray<int32>& Batch : Batches)
+	{
+		int64 Size = 0;
+		for (int32 Index : Batch)
+		{
+			Size += FRetargetUtils::EstimateLoadedMemory(Nodes[Index].AssetData);
+		}
+		BatchSizes.Add(Size);
+	}
+	return BatchSizes;
+}
+
+void FRetargetHierarchy::LoadBlueprints()
+{
+	for (int32 Index : Order)
+	{
+		FNode& Node = Nodes[Index];
+		if (!Node.Blueprint)
+		{
+			RETARGET_PHASE_SCOPE(Load, Node.AssetData.PackageName);
+			Node.Blueprint = Cast<UBlueprint>(Node.AssetData.GetAsset());
+		}
+	}
+}
@@ -0,0 +1,66 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <AssetData.h>
+
+class UBlueprint;
+class UClass;
+
+
+/**
+ * Parent/child graph of a set of blueprints, built from asset registry tags.
+ * Broken blueprints often are the parent of other blueprints in the same set. Only roots need a new parent,
+ * children get fixed by compiling them after their parent.
+ */
+struct FRetargetHierarchy
+{
+	struct FNode
+	{
+		FAssetData AssetData;
+		int32 Parent = INDEX_NONE;
+		TArray<int32> Children;
+		int32 Depth = 0;
+		/** Index of the independent subtree this node belongs to */
+		int32 Batch = INDEX_NONE;
+
+		/** Loaded blueprint, assigned by the user of the hierarchy */
+		UBlueprint* Blueprint = nullptr;
+		/** Class to assign to root blueprints */
+		UClass* NewParent = nullptr;
+	};
+
+	TArray<FNode> Nodes;
+
+	/** Nodes whose parent is not part of the set */
+	TArray<int32> Roots;
+
+	/** Node indices sorted by depth. Parents always go before their children */
+	TArray<int32> Order;
+
+	/** Independent subtrees, each one sorted parents first. They can be retargeted separately */
+	TArray<TArray<int32>> Batches;
+
+
+	FRetargetHierarchy() {}
+	FRetargetHierarchy(const TArray<FAssetData>& Assets);
+
+	int32 GetMaxDepth() const;
+
+	/**
+	 * Groups independent subtrees in chunks whose estimated loaded memory fits the budget. Subtrees are never split,
+	 * unless they contain IsolatedPackages: these get a chunk each, and the rest of their subtree one chunk per depth level.
+	 * Chunks are always sorted parents first
+	 */
+	TArray<TArray<FAssetData>> SplitByMemory(int64 MemoryBudget, const TArray<FName>& IsolatedPackages = {}) const;
+
+	/** Distributes independent subtrees in shards of similar estimated cost, so they can be retargeted by separate processes */
+	TArray<TArray<FAssetData>> SplitInShards(int32 NumShards) const;
+
+	void LoadBlueprints();
+
+private:
+	/** @return estimated loaded memory of each batch */
+	TArray<int64> GetBatchSizes() const;
+};
@@ -0,0 +1,396 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetJob.h"
+#include "BlueprintRetarget.h"
+#include "BrokenBlueprintIndex.h"
+#include "RetargetStats.h"
+#include "RetargetPackageSaver.h"
+#include "RetargetUtils.h"
+
+#include <Engine/Blueprint.h>
+#include <Framework/Application/SlateApplication.h>
+#include <Framework/Notifications/NotificationManager.h>
+#include <HAL/IConsoleManager.h>
+#include <Misc/ScopedSlowTask.h>
+#include <Misc/Timespan.h>
+#include <PackageTools.h>
+#include <ScopedTransaction.h>
+#include <Widgets/Notifications/SNotificationList.h>
+
+
+#define LOCTEXT_NAMESPACE "BlueprintRetarget"
+
+
+static TAutoConsoleVariable<float> CVarRetargetFrameBudget(
+	TEXT("BlueprintRetarget.FrameBudgetMs"),
+	30.f,
+	TEXT("In bulk mode, time per frame spent retargeting blueprints in the editor. 0 retargets everything in a single frame"));
+
+
+TWeakPtr<FRetargetJob> FRetargetJob::Running;
+
+
+FRetargetJob::FRetargetJob(const TArray<TArray<FAssetData>>& InChunks, const TMap<FName, UClass*>& InNewParents, bool bInUnloadChunks, bool bInTransact, bool bInSave)
+	: Chunks(InChunks)
+	, bUnloadChunks(bInUnloadChunks)
+	, bSave(bInSave || bInUnloadChunks)
+	, bTransact(bInTransact)
+{
+	for (const auto& NewParent : InNewParents)
+	{
+		NewParents.Add(NewParent.Key, NewParent.Value);
+	}
+	Retargeter.Journal = &Journal;
+
+	for (const TArray<FAssetData>& Chunk : Chunks)
+	{
+		NumBlueprints += Chunk.Num();
+	}
+}
+
+FRetargetJob::~FRetargetJob()
+{
+	if (FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnPreTick().Remove(PreTickHandle);
+	}
+}
+
+void FRetargetJob::Start(bool bResumeJournal)
+{
+	check(!IsAnyRunning());
+	Self = AsShared();
+	Running = Self;
+	StartTime = FPlatformTime::Seconds();
+
+	// Children keep their current parent, which is recorded too so that they can be resumed alone
+	Journal.Open(FRetargetJournal::GetDefaultFilename(), bResumeJournal);
+	for (const TArray<FAssetData>& Chunk : Chunks)
+	{
+		for (const FAssetData& AssetData : Chunk)
+		{
+			const TWeakObjectPtr<UClass>* NewParent = NewParents.Find(AssetData.ObjectPath);
+			const FString ParentPath = NewParent && NewParent->IsValid() ? (*NewParent)->GetPathName() : FRetargetUtils::GetParentClassPath(AssetData);
+			Journal.Record(AssetData.PackageName, ERetargetJournalState::Pending, ParentPath);
+		}
+	}
+	StartChunk();
+
+	FNotificationInfo Info(FText::GetEmpty());
+	Info.Text = TAttribute<FText>::Create(TAttribute<FText>::FGetter::CreateSP(this, &FRetargetJob::GetProgressText));
+	Info.bFireAndForget = false;
+	Info.bUseThrobber = true;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		LOCTEXT("CancelRetarget", "Cancel"),
+		LOCTEXT("CancelRetarget_Tooltip", "Stops after the blueprint being retargeted. Blueprints already retargeted keep their new parent"),
+		FSimpleDelegate::CreateSP(this, &FRetargetJob::Cancel),
+		SNotificationItem::CS_Pending
+	));
+	Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (TSharedPtr<SNotificationItem> Item = Notification.Pin())
+	{
+		Item->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+
+	PreTickHandle = FSlateApplication::Get().OnPreTick().AddSP(this, &FRetargetJob::OnPreTick);
+}
+
+void FRetargetJob::Cancel()
+{
+	if (bCancelled || bFinished)
+	{
+		return;
+	}
+
+	// Blueprints halfway done are still finished, the job stops on the next tick after that
+	bCancelled = true;
+	if (Task)
+	{
+		Task->Cancel();
+	}
+	UE_LOG(LogBlueprintReparent, Log, TEXT("Retarget cancelled"));
+}
+
+bool FRetargetJob::Step()
+{
+	switch (CurrentStep)
+	{
+	case EStep::Load:
+		if (bCancelled)
+		{
+			return false;
+		}
+
+		if (LoadIndex < Hierarchy.Order.Num())
+		{
+			FRetargetHierarchy::FNode& Node = Hierarchy.Nodes[Hierarchy.Order[LoadIndex++]];
+			if (!Node.Blueprint)
+			{
+				RETARGET_PHASE_SCOPE(Load, Node.AssetData.PackageName);
+				Journal.SetActive({ Node.AssetData.PackageName });
+				Node.Blueprint = Cast<UBlueprint>(Node.AssetData.GetAsset());
+				if (!Node.Blueprint)
+				{
+					Journal.Record(Node.AssetData.PackageName, ERetargetJournalState::Failed, TEXT("LoadFailed"));
+				}
+			}
+			return true;
+		}
+
+		for (int32 Root : Hierarchy.Roots)
+		{
+			FRetargetHierarchy::FNode& Node = Hierarchy.Nodes[Root];
+			const TWeakObjectPtr<UClass>* NewParent = NewParents.Find(Node.AssetData.ObjectPath);
+			Node.NewParent = NewParent ? NewParent->Get() : nullptr;
+			if (NewParent && !Node.NewParent)
+			{
+				UE_LOG(LogBlueprintReparent, Error, TEXT("New parent of %s got deleted. It won't be retargeted"), *Node.AssetData.ObjectPath.ToString());
+			}
+		}
+		Task = MakeUnique<FRetargetHierarchyTask>(Retargeter, Hierarchy);
+		CurrentStep = EStep::Retarget;
+		return true;
+
+	case EStep::Retarget:
+		if (Task->Step())
+		{
+			return true;
+		}
+
+		NumRetargeted += Task->GetRetargeted().Num();
+		for (UBlueprint* Blueprint : Task->GetRetargeted())
+		{
+			FBrokenBlueprintIndex::Get().Refresh(FAssetData(Blueprint));
+			RetargetedPackages.Add(Blueprint->GetOutermost()->GetFName());
+		}
+		Task.Reset();
+		CurrentStep = EStep::Unload;
+		return true;
+
+	case EStep::Unload:
+		if (bSave)
+		{
+			SaveChunk();
+		}
+		if (bUnloadChunks)
+		{
+			UnloadChunk();
+		}
+
+		NumDone += Chunks[ChunkIndex].Num();
+		if (bCancelled || ++ChunkIndex >= Chunks.Num())
+		{
+			return false;
+		}
+		StartChunk();
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void FRetargetJob::StartChunk()
+{
+	if (Chunks.Num() > 1)
+	{
+		UE_LOG(LogBlueprintReparent, Log, TEXT("Retargeting chunk %i of %i (%i blueprints)"), ChunkIndex + 1, Chunks.Num(), Chunks[ChunkIndex].Num());
+	}
+
+	Hierarchy = FRetargetHierarchy{ Chunks[ChunkIndex] };
+	LoadIndex = 0;
+	CurrentStep = EStep::Load;
+}
+
+void FRetargetJob::SaveChunk()
+{
+	TArray<UPackage*> Packages;
+	TSet<UPackage*> CompileFailed;
+	for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
+	{
+		if (Node.Blueprint && Node.Blueprint->GetOutermost()->IsDirty())
+		{
+			Packages.AddUnique(Node.Blueprint->GetOutermost());
+			if (Node.Blueprint->Status == BS_Error)
+			{
+				CompileFailed.Add(Node.Blueprint->GetOutermost());
+			}
+		}
+	}
+
+	if (Packages.Num() <= 0)
+	{
+		return;
+	}
+
+	TArray<FName> PackageNames;
+	for (const UPackage* Package : Packages)
+	{
+		PackageNames.Add(Package->GetFName());
+	}
+	Journal.SetActive(PackageNames);
+
+	const FRetargetSaveResult Result = FRetargetPackageSaver::Save(Packages);
+	for (UPackage* Package : Packages)
+	{
+		// Blueprints with compile errors are still saved, but the journal keeps them as failed
+		const FString* Failure = Result.Failed.Find(Package);
+		if (!Failure && CompileFailed.Contains(Package))
+		{
+			Journal.Record(Package->GetFName(), ERetargetJournalState::Failed, TEXT("CompileFailed"));
+			continue;
+		}
+		Journal.Record(Package->GetFName(), Failure ? ERetargetJournalState::Failed : ERetargetJournalState::Saved, Failure ? *Failure : FString{});
+	}
+	NumSaveFailed += Result.Failed.Num();
+}
+
+void FRetargetJob::UnloadChunk()
+{
+	TArray<UPackage*> Packages;
+	for (const FRetargetHierarchy::FNode& Node : Hierarchy.Nodes)
+	{
+		// Packages that failed to save keep their changes in memory
+		if (Node.Blueprint && !Node.Blueprint->GetOutermost()->IsDirty())
+		{
+			Packages.AddUnique(Node.Blueprint->GetOutermost());
+		}
+	}
+
+	// Unloaded blueprints must not be referenced anymore
+	Hierarchy = FRetargetHierarchy{};
+
+	RETARGET_PHASE_SCOPE(GarbageCollect, NAME_None);
+	UPackageTools::UnloadPackages(Packages);
+}
+
+void FRetargetJob::Finish()
+{
+	bFinished = true;
+	Task.Reset();
+	Journal.Finish();
+
+	if (FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnPreTick().Remove(PreTickHandle);
+		PreTickHandle.Reset();
+	}
+
+	if (TSharedPtr<SNotificationItem> Item = Notification.Pin())
+	{
+		Item->SetText(GetProgressText());
+		Item->SetCompletionState(bCancelled ? SNotificationItem::CS_None : NumSaveFailed > 0 ? SNotificationItem::CS_Fail : SNotificationItem::CS_Success);
+		Item->ExpireAndFadeout();
+	}
+	Notification.Reset();
+
+	UE_LOG(LogBlueprintReparent, Log, TEXT("Retarget %s after %.2fs"), bCancelled ? TEXT("cancelled") : TEXT("finished"), FPlatformTime::Seconds() - StartTime);
+	OnFinished.ExecuteIfBound();
+
+	Running.Reset();
+	Self.Reset();
+}
+
+void FRetargetJob::OnPreTick(float DeltaTime)
+{
+	// Dialogs opened by the retarget tick slate again. The job must not run inside itself
+	if (bTicking || bFinished)
+	{
+		return;
+	}
+	TGuardValue<bool> TickingGuard(bTicking, true);
+
+	// Finishing releases the job, but not before this tick returns
+	TSharedRef<FRetargetJob> KeepAlive = AsShared();
+
+	// A transaction can't stay open across frames. Transacted jobs are done in this tick, behind a progress dialog
+	FScopedTransaction Transaction(LOCTEXT("RetargetBlueprintParents", "Retarget Blueprint parents"), bTransact);
+	TOptional<FScopedSlowTask> SlowTask;
+	if (bTransact)
+	{
+		SlowTask.Emplace(1.f, GetProgressText());
+		SlowTask->MakeDialog(true);
+	}
+
+	const double Budget = bTransact ? 0.0 : GetFrameBudgetMs() / 1000.0;
+	const double FrameStart = FPlatformTime::Seconds();
+	float LastProgress = GetProgress();
+	do
+	{
+		if (!Step())
+		{
+			Finish();
+			return;
+		}
+
+		if (SlowTask)
+		{
+			const float Progress = GetProgress();
+			SlowTask->EnterProgressFrame(Progress - LastProgress, GetProgressText());
+			LastProgress = Progress;
+			if (SlowTask->ShouldCancel())
+			{
+				Cancel();
+			}
+		}
+	}
+	while (Budget <= 0.0 || FPlatformTime::Seconds() - FrameStart < Budget);
+}
+
+float FRetargetJob::GetFrameBudgetMs()
+{
+	return CVarRetargetFrameBudget.GetValueOnGameThread();
+}
+
+float FRetargetJob::GetProgress() const
+{
+	if (NumBlueprints <= 0)
+	{
+		return 1.f;
+	}
+
+	// Loading and retargeting a blueprint count the same
+	int32 Done = NumDone * 2;
+	switch (CurrentStep)
+	{
+	case EStep::Load:     Done += LoadIndex; break;
+	case EStep::Retarget: Done += Hierarchy.Nodes.Num() + (Task ? Task->GetNumProcessed() : 0); break;
+	case EStep::Unload:   Done += Hierarchy.Nodes.Num() * 2; break;
+	}
+	return FMath::Clamp(float(Done) / (NumBlueprints * 2), 0.f, 1.f);
+}
+
+FText FRetargetJob::GetProgressText() const
+{
+	if (bFinished && NumSaveFailed > 0)
+	{
+		return FText::Format(LOCTEXT("RetargetSaveFailed", "Retargeted {0} blueprints. {1} packages couldn't be saved, see the log"),
+			FText::AsNumber(NumRetargeted), FText::AsNumber(NumSaveFailed));
+	}
+	if (bFinished)
+	{
+		return bCancelled
+			? FText::Format(LOCTEXT("RetargetCancelled", "Retarget cancelled. {0} of {1} blueprints were retargeted"), FText::AsNumber(NumRetargeted), FText::AsNumber(NumBlueprints))
+			: FText::Format(LOCTEXT("RetargetFinished", "Retargeted {0} blueprints"), FText::AsNumber(NumRetargeted));
+	}
+	if (bCancelled)
+	{
+		return LOCTEXT("RetargetCancelling", "Cancelling retarget...");
+	}
+
+	const int32 Done = FMath::Min(NumDone + (Task ? Task->GetNumProcessed() : 0), NumBlueprints);
+
+	// Time left is estimated once there is some progress to extrapolate from
+	const float Progress = GetProgress();
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+	if (Progress < 0.01f || Elapsed < 2.0)
+	{
+		return FText::Format(LOCTEXT("RetargetProgress", "Retargeting blueprints ({0}/{1})"), FText::AsNumber(Done), FText::AsNumber(NumBlueprints));
+	}
+
+	const FTimespan Remaining = FTimespan::FromSeconds(FMath::CeilToDouble(Elapsed * (1.f - Progress) / Progress));
+	return FText::Format(LOCTEXT("RetargetProgressEta", "Retargeting blueprints ({0}/{1}), {2} left"),
+		FText::AsNumber(Done), FText::AsNumber(NumBlueprints), FText::AsTimespan(Remaining));
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,115 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <AssetData.h>
+#include <Templates/SharedPointer.h>
+
+#include "BlueprintRetargeter.h"
+#include "RetargetHierarchy.h"
+#include "RetargetJournal.h"
+
+class SNotificationItem;
+class UClass;
+
+
+/**
+ * Retargets blueprints over several frames so that the editor keeps responding.
+ * Each frame works for up to BlueprintRetarget.FrameBudgetMs, and only stops between blueprints.
+ * Transacted jobs are done in a single frame instead, behind a progress dialog.
+ * Progress is shown with the estimated time left and a button to cancel.
+ * Every blueprint is recorded on a journal, so that the job can be resumed if the editor crashes.
+ */
+class FRetargetJob : public TSharedFromThis<FRetargetJob>
+{
+	enum class EStep : uint8
+	{
+		Load,
+		Retarget,
+		Unload
+	};
+
+	TArray<TArray<FAssetData>> Chunks;
+	/** Root blueprint object path -> New parent */
+	TMap<FName, TWeakObjectPtr<UClass>> NewParents;
+	bool bUnloadChunks = false;
+	bool bSave = false;
+	bool bTransact = false;
+	int32 NumBlueprints = 0;
+
+	FBlueprintRetargeter Retargeter;
+	FRetargetJournal Journal;
+
+	int32 ChunkIndex = 0;
+	EStep CurrentStep = EStep::Load;
+	FRetargetHierarchy Hierarchy;
+	int32 LoadIndex = 0;
+	TUniquePtr<FRetargetHierarchyTask> Task;
+
+	/** Blueprints of previous chunks */
+	int32 NumDone = 0;
+	int32 NumRetargeted = 0;
+	int32 NumSaveFailed = 0;
+	TArray<FName> RetargetedPackages;
+	double StartTime = 0.0;
+
+	TWeakPtr<SNotificationItem> Notification;
+	FDelegateHandle PreTickHandle;
+	bool bCancelled = false;
+	bool bFinished = false;
+	bool bTicking = false;
+
+	/** The job keeps itself alive while running */
+	TSharedPtr<FRetargetJob> Self;
+
+	static TWeakPtr<FRetargetJob> Running;
+
+
+public:
+	/** Called once the job finished or got cancelled */
+	FSimpleDelegate OnFinished;
+
+
+	/**
+	 * @param InChunks parts of the selection retargeted one after another
+	 * @param InNewParents new parent of each root blueprint, by object path. Blueprints without one are not retargeted
+	 * @param bInUnloadChunks if true, each chunk is saved and unloaded before loading the next one
+	 * @param bInTransact if true, the whole retarget is a single undo transaction. It is then done in a single frame
+	 * @param bInSave if true, each chunk is saved once retargeted. Files should be checked out already
+	 */
+	FRetargetJob(const TArray<TArray<FAssetData>>& InChunks, const TMap<FName, UClass*>& InNewParents, bool bInUnloadChunks, bool bInTransact, bool bInSave);
+	~FRetargetJob();
+
+	/** @param bResumeJournal if true, continues the journal of an interrupted job instead of starting a new one */
+	void Start(bool bResumeJournal = false);
+	void Cancel();
+
+	bool IsCancelled() const { return bCancelled; }
+	bool IsFinished() const { return bFinished; }
+
+	/** Packages of the blueprints reparented or recompiled so far */
+	const TArray<FName>& GetRetargetedPackages() const { return RetargetedPackages; }
+
+	/** @return true if a job is retargeting blueprints. Only one can run at a time */
+	static bool IsAnyRunning() { return Running.IsValid(); }
+
+	/** Time per frame spent retargeting jobs without transaction. 0 if they are done in a single frame */
+	static float GetFrameBudgetMs();
+
+private:
+	/** Does the next unit of work. @return false once finished */
+	bool Step();
+
+	void StartChunk();
+	/** Saves modified packages of the chunk together. Packages that fail are reported and kept dirty */
+	void SaveChunk();
+	void UnloadChunk();
+	void Finish();
+
+	void OnPreTick(float DeltaTime);
+
+	/** @return completed fraction of the work, from 0 to 1 */
+	float GetProgress() const;
+	FText GetProgressText() const;
+};
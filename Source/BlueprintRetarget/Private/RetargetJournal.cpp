@@ -0,0 +1,209 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetJournal.h"
+#include "BlueprintRetarget.h"
+
+#include <Algo/Find.h>
+#include <HAL/FileManager.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+
+
+static const TCHAR* ActiveTag = TEXT("Active");
+static const TCHAR* FinishedTag = TEXT("Finished");
+static const TCHAR* MappingsTag = TEXT("Mappings");
+
+static constexpr ERetargetJournalState AllStates[] = {
+	ERetargetJournalState::Pending,
+	ERetargetJournalState::Reparented,
+	ERetargetJournalState::Compiled,
+	ERetargetJournalState::Saved,
+	ERetargetJournalState::Failed,
+	ERetargetJournalState::Quarantined
+};
+
+
+bool FRetargetJournal::Open(const FString& InFilename, bool bAppend)
+{
+	Filename = InFilename;
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*Filename, bAppend ? FILEWRITE_Append : FILEWRITE_None));
+	if (!Writer)
+	{
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("Couldn't open retarget journal '%s'. The retarget won't be resumable"), *Filename);
+		return false;
+	}
+	return true;
+}
+
+bool FRetargetJournal::Resume(const FString& InFilename, FRetargetJournalContents& OutContents, TArray<FName>& OutSuspects)
+{
+	if (!Read(InFilename, OutContents) || OutContents.bFinished || !Open(InFilename, true))
+	{
+		return false;
+	}
+
+	int32 NumDone = 0;
+	for (const auto& Entry : OutContents.Entries)
+	{
+		NumDone += Entry.Value.IsDone();
+	}
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Resuming an interrupted retarget: %i of %i blueprints were done"), NumDone, OutContents.Entries.Num());
+
+	OutSuspects.Reset();
+	if (OutContents.Active.Num() == 1)
+	{
+		const FName Culprit = OutContents.Active[0];
+		const FString Reason = TEXT("Crashed the previous run");
+		Record(Culprit, ERetargetJournalState::Quarantined, Reason);
+
+		FRetargetJournalEntry& Entry = OutContents.Entries.FindOrAdd(Culprit);
+		Entry.State = ERetargetJournalState::Quarantined;
+		Entry.Reason = Reason;
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("%s was being retargeted when the previous run stopped. It is quarantined"), *Culprit.ToString());
+	}
+	else if (OutContents.Active.Num() > 1)
+	{
+		OutSuspects = OutContents.Active;
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("%i blueprints were being retargeted together when the previous run stopped. They will be retargeted one at a time"), OutSuspects.Num());
+	}
+	return true;
+}
+
+void FRetargetJournal::Finish()
+{
+	if (!Writer)
+	{
+		return;
+	}
+
+	WriteLine(FinishedTag);
+	Writer.Reset();
+	IFileManager::Get().Delete(*Filename, false, false, true);
+}
+
+void FRetargetJournal::Record(FName Package, ERetargetJournalState State, const FString& Detail)
+{
+	// Tabs separate fields and each record is a line
+	FString SafeDetail = Detail.Replace(TEXT("\t"), TEXT(" "));
+	SafeDetail.ReplaceInline(TEXT("\n"), TEXT(" "));
+	SafeDetail.ReplaceInline(TEXT("\r"), TEXT(" "));
+
+	WriteLine(FString::Printf(TEXT("%s\t%s\t%s"), GetStateName(State), *Package.ToString(), *SafeDetail));
+}
+
+void FRetargetJournal::SetActive(const TArray<FName>& Packages)
+{
+	FString Line = ActiveTag;
+	for (const FName& Package : Packages)
+	{
+		Line += TEXT("\t");
+		Line += Package.ToString();
+	}
+	WriteLine(Line);
+}
+
+void FRetargetJournal::SetMappingsHash(const FString& Hash)
+{
+	WriteLine(FString::Printf(TEXT("%s\t%s"), MappingsTag, *Hash));
+}
+
+bool FRetargetJournal::Read(const FString& Filename, FRetargetJournalContents& OutContents)
+{
+	OutContents = {};
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		return false;
+	}
+
+	TSet<FName> Active;
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Fields;
+		Line.ParseIntoArray(Fields, TEXT("\t"), false);
+		if (Fields.Num() <= 0)
+		{
+			continue;
+		}
+
+		if (Fields[0] == FinishedTag)
+		{
+			OutContents.bFinished = true;
+			continue;
+		}
+		if (Fields[0] == MappingsTag)
+		{
+			OutContents.MappingsHash = Fields.Num() > 1 ? Fields[1] : FString{};
+			continue;
+		}
+		if (Fields[0] == ActiveTag)
+		{
+			Active.Reset();
+			for (int32 Index = 1; Index < Fields.Num(); ++Index)
+			{
+				Active.Add(FName(*Fields[Index]));
+			}
+			continue;
+		}
+
+		// The last line can be cut if the process died while writing it
+		const ERetargetJournalState* State = Algo::FindByPredicate(AllStates, [&Fields](ERetargetJournalState Candidate) {
+			return Fields[0] == GetStateName(Candidate);
+		});
+		if (!State || Fields.Num() < 3)
+		{
+			continue;
+		}
+
+		const FName Package{ *Fields[1] };
+		FRetargetJournalEntry& Entry = OutContents.Entries.FindOrAdd(Package);
+		Entry.State = *State;
+		if (*State == ERetargetJournalState::Failed || *State == ERetargetJournalState::Quarantined)
+		{
+			Entry.Reason = Fields[2];
+		}
+		else if (!Fields[2].IsEmpty())
+		{
+			Entry.NewParent = Fields[2];
+		}
+
+		// Anything recorded after it started means it didn't crash there
+		Active.Remove(Package);
+	}
+
+	OutContents.Active = Active.Array();
+	return true;
+}
+
+FString FRetargetJournal::GetDefaultFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("BlueprintRetarget") / (IsRunningCommandlet() ? TEXT("Journal.log") : TEXT("EditorJournal.log"));
+}
+
+const TCHAR* FRetargetJournal::GetStateName(ERetargetJournalState State)
+{
+	switch (State)
+	{
+	case ERetargetJournalState::Pending:     return TEXT("Pending");
+	case ERetargetJournalState::Reparented:  return TEXT("Reparented");
+	case ERetargetJournalState::Compiled:    return TEXT("Compiled");
+	case ERetargetJournalState::Saved:       return TEXT("Saved");
+	case ERetargetJournalState::Failed:      return TEXT("Failed");
+	case ERetargetJournalState::Quarantined: return TEXT("Quarantined");
+	default:                                 return TEXT("Unknown");
+	}
+}
+
+void FRetargetJournal::WriteLine(const FString& Line)
+{
+	if (!Writer)
+	{
+		return;
+	}
+
+	// Flushed right away. Anything still buffered is lost if the process crashes
+	FTCHARToUTF8 Utf8(*(Line + TEXT("\n")));
+	Writer->Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+	Writer->Flush();
+}
@@ -0,0 +1,102 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+enum class ERetargetJournalState : uint8
+{
+	Pending,
+	Reparented,
+	Compiled,
+	Saved,
+	Failed,
+	/** Crashed a previous run. Not retargeted again */
+	Quarantined
+};
+
+
+/** Last state of a blueprint package in a journal */
+struct FRetargetJournalEntry
+{
+	ERetargetJournalState State = ERetargetJournalState::Pending;
+
+	/** Path of the parent class chosen for it. Empty if it wasn't chosen yet */
+	FString NewParent;
+
+	/** Why it failed or got quarantined */
+	FString Reason;
+
+
+	/** @return true if the result is already on disk, and the blueprint doesn't need to be retargeted again */
+	bool IsDone() const
+	{
+		return State == ERetargetJournalState::Saved || State == ERetargetJournalState::Failed || State == ERetargetJournalState::Quarantined;
+	}
+};
+
+
+struct FRetargetJournalContents
+{
+	/** Package name -> Last recorded state, in the order they were first recorded */
+	TMap<FName, FRetargetJournalEntry> Entries;
+
+	/** Packages being processed when the journal stopped. If the run crashed, one of them caused it */
+	TArray<FName> Active;
+
+	/** Hash of the mapping file the run was started with. Empty if it had none */
+	FString MappingsHash;
+
+	/** True if the run finished normally */
+	bool bFinished = false;
+};
+
+
+/**
+ * Append-only record of the state of each blueprint of a retarget, flushed after every line so that it survives
+ * a crash or the process getting killed. The next run reads it to continue where the previous one stopped.
+ * The journal is deleted once the run finishes. If it never does, the file is kept.
+ */
+class FRetargetJournal
+{
+	FString Filename;
+	TUniquePtr<FArchive> Writer;
+
+
+public:
+	/** Starts recording. Any previous journal in the same file is discarded unless bAppend */
+	bool Open(const FString& InFilename, bool bAppend = false);
+
+	/**
+	 * Continues an interrupted journal. If a single blueprint was being processed when it stopped, it gets quarantined.
+	 * If several were (E.g: compiled together), they are output as suspects, to be retargeted one at a time.
+	 * @return false if there is no interrupted journal to resume
+	 */
+	bool Resume(const FString& InFilename, FRetargetJournalContents& OutContents, TArray<FName>& OutSuspects);
+
+	/** Marks the run as finished and deletes the journal */
+	void Finish();
+
+	bool IsOpen() const { return Writer.IsValid(); }
+
+	/** @param Detail parent class path for Pending and Reparented, reason for Failed and Quarantined */
+	void Record(FName Package, ERetargetJournalState State, const FString& Detail = {});
+
+	/** Records the packages about to be processed, before any step that could crash */
+	void SetActive(const TArray<FName>& Packages);
+
+	/** Records the mapping file the run uses. A run with a different one can't resume it */
+	void SetMappingsHash(const FString& Hash);
+
+	/** @return false if the file doesn't exist */
+	static bool Read(const FString& Filename, FRetargetJournalContents& OutContents);
+
+	/** Editor and commandlet runs use different journals */
+	static FString GetDefaultFilename();
+
+	static const TCHAR* GetStateName(ERetargetJournalState State);
+
+private:
+	void WriteLine(const FString& Line);
+};
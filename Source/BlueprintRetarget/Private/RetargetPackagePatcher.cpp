@@ -0,0 +1,389 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetPackagePatcher.h"
+#include "RetargetPackageReader.h"
+#include "BlueprintRetarget.h"
+
+#include <HAL/FileManager.h>
+#include <Misc/FileHelper.h>
+#include <Misc/PackageName.h>
+#include <Serialization/MemoryReader.h>
+#include <Serialization/MemoryWriter.h>
+#include <UObject/Class.h>
+#include <UObject/Package.h>
+
+
+/** A range of the original file replaced by new bytes. Empty ranges insert bytes */
+struct FPatchSegment
+{
+	int64 Start = 0;
+	int64 End = 0;
+	TArray<uint8> Bytes;
+};
+
+
+/** @return where a position of the original file ends up after applying the segments */
+static int64 ShiftPosition(const TArray<FPatchSegment>& Segments, int64 Position)
+{
+	int64 NewPosition = Position;
+	for (const FPatchSegment& Segment : Segments)
+	{
+		if (Segment.End <= Position)
+		{
+			NewPosition += Segment.Bytes.Num() - (Segment.End - Segment.Start);
+		}
+	}
+	return NewPosition;
+}
+
+/** @return true if writing the tables as read produces the same bytes */
+static bool SerializesBack(FRetargetPackageReader& Reader, const TArray<uint8>& Original)
+{
+	TArray<FName> NameMap = Reader.NameMap;
+	auto Matches = [&](int64 Start, int64 End, TFunctionRef<void(FRetargetPackageWriter&)> Write) {
+		TArray<uint8> Bytes;
+		FRetargetPackageWriter Writer{ Bytes, NameMap, Reader };
+		Write(Writer);
+		return Bytes.Num() == End - Start && FMemory::Memcmp(Bytes.GetData(), Original.GetData() + Start, Bytes.Num()) == 0;
+	};
+
+	const bool bSummary = Matches(0, Reader.SummaryEnd, [&Reader](FRetargetPackageWriter& Writer) {
+		Writer << Reader.Summary;
+	});
+	const bool bImports = Matches(Reader.Summary.ImportOffset, Reader.ImportsEnd, [&Reader](FRetargetPackageWriter& Writer) {
+		for (FObjectImport& Import : Reader.Imports)
+		{
+			Writer << Import;
+		}
+	});
+	const bool bExports = Matches(Reader.Summary.ExportOffset, Reader.ExportsEnd, [&Reader](FRetargetPackageWriter& Writer) {
+		for (FObjectExport& Export : Reader.Exports)
+		{
+			Writer << Export;
+		}
+	});
+
+	// No name can be missing from the map
+	return bSummary && bImports && bExports && NameMap.Num() == Reader.NameMap.Num();
+}
+
+/**
+ * Replaces tag values of the asset registry data of the package.
+ * @return false if the data has an unknown format
+ */
+static bool RewriteTags(const TArray<uint8>& Original, int64 Start, int64 End, const TMap<FString, FString>& Replacements, TArray<uint8>& OutBytes)
+{
+	FMemoryReader Reader{ Original };
+	Reader.Seek(Start);
+
+	int32 ObjectCount = 0;
+	Reader << ObjectCount;
+	if (ObjectCount < 0 || ObjectCount > 1024)
+	{
+		return false;
+	}
+
+	FMemoryWriter Writer{ OutBytes };
+	Writer << ObjectCount;
+	for (int32 Object = 0; Object < ObjectCount && !Reader.IsError(); ++Object)
+	{
+		FString ObjectPath;
+		FString ObjectClassName;
+		int32 TagCount = 0;
+		Reader << ObjectPath << ObjectClassName << TagCount;
+		Writer << ObjectPath << ObjectClassName << TagCount;
+
+		for (int32 Tag = 0; Tag < TagCount && !Reader.IsError() && Reader.Tell() < End; ++Tag)
+		{
+			FString Key;
+			FString Value;
+			Reader << Key << Value;
+			if (const FString* NewValue = Replacements.Find(Value))
+			{
+				Value = *NewValue;
+			}
+			Writer << Key << Value;
+		}
+	}
+
+	// The whole section must have been understood
+	return !Reader.IsError() && Reader.Tell() == End;
+}
+
+/** Shifts the file offsets of the thumbnail table, which keeps its size */
+static bool ShiftThumbnails(const TArray<uint8>& Original, int64 Start, const TArray<FPatchSegment>& Segments, FPatchSegment& OutSegment)
+{
+	FMemoryReader Reader{ Original };
+	Reader.Seek(Start);
+	FMemoryWriter Writer{ OutSegment.Bytes };
+
+	int32 Count = 0;
+	Reader << Count;
+	Writer << Count;
+	for (int32 I = 0; I < Count && !Reader.IsError(); ++I)
+	{
+		FString ObjectClassName;
+		FString ObjectPath;
+		int32 FileOffset = 0;
+		Reader << ObjectClassName << ObjectPath << FileOffset;
+
+		FileOffset = int32(ShiftPosition(Segments, FileOffset));
+		Writer << ObjectClassName << ObjectPath << FileOffset;
+	}
+
+	OutSegment.Start = Start;
+	OutSegment.End = Reader.Tell();
+	return !Reader.IsError();
+}
+
+
+bool FRetargetPackagePatcher::PatchParentClass(const FString& Filename, const FString& OldParentPath, const UClass* NewParent, FString& OutError)
+{
+	TArray<uint8> Original;
+	if (!NewParent || !FFileHelper::LoadFileToArray(Original, *Filename))
+	{
+		OutError = TEXT("Couldn't read the package");
+		return false;
+	}
+
+	FRetargetPackageReader Reader;
+	if (!Reader.Open(Original) || !Reader.ReadTables())
+	{
+		OutError = TEXT("Couldn't read the package tables");
+		return false;
+	}
+
+	FPackageFileSummary& Summary = Reader.Summary;
+	const int64 ExportOffset = Summary.ExportOffset;
+	if ((Summary.PackageFlags & PKG_FilterEditorOnly) || Summary.CompressedChunks.Num() > 0)
+	{
+		OutError = TEXT("Cooked or compressed packages can't be patched");
+		return false;
+	}
+	if (Summary.BulkDataStartOffset + int64(sizeof(uint32)) < Original.Num())
+	{
+		OutError = TEXT("Packages with bulk data can't be patched");
+		return false;
+	}
+	if (!SerializesBack(Reader, Original))
+	{
+		OutError = TEXT("Package tables don't serialize back identically");
+		return false;
+	}
+
+	// Find the old parent and its default object
+	TArray<FObjectImport>& Imports = Reader.Imports;
+	const FString OldPath = FPackageName::ExportTextPathToObjectPath(OldParentPath);
+	int32 ClassIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < Imports.Num(); ++Index)
+	{
+		if (Reader.GetImportPath(Index) == OldPath)
+		{
+			ClassIndex = Index;
+			break;
+		}
+	}
+	if (ClassIndex == INDEX_NONE || !Imports[ClassIndex].OuterIndex.IsImport())
+	{
+		OutError = FString::Printf(TEXT("'%s' is not imported by the package"), *OldPath);
+		return false;
+	}
+
+	const FPackageIndex OldPackage = Imports[ClassIndex].OuterIndex;
+	const FName OldDefaultName{ *(DEFAULT_OBJECT_PREFIX + Imports[ClassIndex].ObjectName.ToString()) };
+	const int32 DefaultIndex = Imports.IndexOfByPredicate([&](const FObjectImport& Import) {
+		return Import.OuterIndex == OldPackage && Import.ObjectName == OldDefaultName;
+	});
+
+	// The old package can be renamed if nothing else is imported from it
+	const FName NewPackageName = NewParent->GetOutermost()->GetFName();
+	int32 NewPackageIndex = Imports.IndexOfByPredicate([&](const FObjectImport& Import) {
+		return Import.OuterIndex.IsNull() && Import.ObjectName == NewPackageName;
+	});
+	if (NewPackageIndex == INDEX_NONE)
+	{
+		int32 OldPackageUsers = 0;
+		for (const FObjectImport& Import : Imports)
+		{
+			OldPackageUsers += Import.OuterIndex == OldPackage;
+		}
+
+		if (OldPackageUsers <= (DefaultIndex != INDEX_NONE ? 2 : 1))
+		{
+			NewPackageIndex = OldPackage.ToImport();
+		}
+		else
+		{
+			const FObjectImport PackageImport = Imports[OldPackage.ToImport()];
+			NewPackageIndex = Imports.Add(PackageImport);
+		}
+		Imports[NewPackageIndex].ObjectName = NewPackageName;
+	}
+	const FPackageIndex NewPackage = FPackageIndex::FromImport(NewPackageIndex);
+
+	FObjectImport& ClassImport = Imports[ClassIndex];
+	ClassImport.ClassPackage = NewParent->GetClass()->GetOutermost()->GetFName();
+	ClassImport.ClassName = NewParent->GetClass()->GetFName();
+	ClassImport.ObjectName = NewParent->GetFName();
+	ClassImport.OuterIndex = NewPackage;
+
+	if (DefaultIndex != INDEX_NONE)
+	{
+		FObjectImport& DefaultImport = Imports[DefaultIndex];
+		DefaultImport.ClassPackage = NewPackageName;
+		DefaultImport.ClassName = NewParent->GetFName();
+		DefaultImport.ObjectName = FName{ *(DEFAULT_OBJECT_PREFIX + NewParent->GetName()) };
+		DefaultImport.OuterIndex = NewPackage;
+	}
+
+	// New names go to the end of the name map, so existing name indices stay valid
+	TArray<FName> NameMap = Reader.NameMap;
+	TArray<FPatchSegment> Segments;
+	{
+		FPatchSegment& ImportTable = Segments.AddDefaulted_GetRef();
+		ImportTable.Start = Summary.ImportOffset;
+		ImportTable.End = Reader.ImportsEnd;
+		FRetargetPackageWriter Writer{ ImportTable.Bytes, NameMap, Reader };
+		for (FObjectImport& Import : Imports)
+		{
+			Writer << Import;
+		}
+	}
+	{
+		FPatchSegment NewNames;
+		NewNames.Start = NewNames.End = Reader.NameMapEnd;
+		FRetargetPackageWriter Writer{ NewNames.Bytes, NameMap, Reader };
+		for (int32 Index = Reader.NameMap.Num(); Index < NameMap.Num(); ++Index)
+		{
+			NameMap[Index].GetDisplayNameEntry()->Write(Writer);
+		}
+		Segments.Insert(MoveTemp(NewNames), 0);
+	}
+
+	// Tags still name the old parent until updated, and the asset registry would keep the blueprint as broken
+	if (Summary.AssetRegistryDataOffset > 0)
+	{
+		int64 End = Summary.TotalHeaderSize;
+		for (int64 Offset : { int64(Summary.WorldTileInfoDataOffset), int64(Summary.PreloadDependencyOffset), int64(Summary.ThumbnailTableOffset) })
+		{
+			if (Offset > Summary.AssetRegistryDataOffset && Offset < End)
+			{
+				End = Offset;
+			}
+		}
+
+		const FString OldTag = FString::Printf(TEXT("%s'%s'"), *UClass::StaticClass()->GetName(), *OldPath);
+		const FString NewTag = FString::Printf(TEXT("%s'%s'"), *NewParent->GetClass()->GetName(), *NewParent->GetPathName());
+		const TMap<FString, FString> Replacements{ { OldTag, NewTag }, { OldPath, NewParent->GetPathName() } };
+
+		FPatchSegment Tags;
+		Tags.Start = Summary.AssetRegistryDataOffset;
+		Tags.End = End;
+		if (RewriteTags(Original, Tags.Start, Tags.End, Replacements, Tags.Bytes))
+		{
+			Segments.Add(MoveTemp(Tags));
+		}
+		else
+		{
+			UE_LOG(LogBlueprintReparent, Warning, TEXT("Unknown asset registry data in '%s'. Its tags will update on next save"), *Filename);
+		}
+	}
+
+	// Fix every absolute offset after the segments
+	FPatchSegment Thumbnails;
+	if (Summary.ThumbnailTableOffset > 0 && !ShiftThumbnails(Original, Summary.ThumbnailTableOffset, Segments, Thumbnails))
+	{
+		OutError = TEXT("Couldn't read the thumbnail table");
+		return false;
+	}
+
+	for (FObjectExport& Export : Reader.Exports)
+	{
+		Export.SerialOffset = ShiftPosition(Segments, Export.SerialOffset);
+	}
+
+	auto ShiftOffset = [&Segments](int32& Offset) {
+		if (Offset > 0)
+		{
+			Offset = int32(ShiftPosition(Segments, Offset));
+		}
+	};
+	ShiftOffset(Summary.TotalHeaderSize);
+	ShiftOffset(Summary.GatherableTextDataOffset);
+	ShiftOffset(Summary.ImportOffset);
+	ShiftOffset(Summary.ExportOffset);
+	ShiftOffset(Summary.DependsOffset);
+	ShiftOffset(Summary.SoftPackageReferencesOffset);
+	ShiftOffset(Summary.SearchableNamesOffset);
+	ShiftOffset(Summary.ThumbnailTableOffset);
+	ShiftOffset(Summary.AssetRegistryDataOffset);
+	ShiftOffset(Summary.WorldTileInfoDataOffset);
+	ShiftOffset(Summary.PreloadDependencyOffset);
+	Summary.BulkDataStartOffset = ShiftPosition(Segments, Summary.BulkDataStartOffset);
+	Summary.NameCount = NameMap.Num();
+	Summary.ImportCount = Imports.Num();
+	if (Summary.Generations.Num() > 0)
+	{
+		Summary.Generations.Last().NameCount = NameMap.Num();
+	}
+
+	// Summary, exports and thumbnails keep their size, so they don't move anything
+	{
+		FPatchSegment& SummarySegment = Segments.AddDefaulted_GetRef();
+		SummarySegment.End = Reader.SummaryEnd;
+		FRetargetPackageWriter Writer{ SummarySegment.Bytes, NameMap, Reader };
+		Writer << Summary;
+	}
+	{
+		FPatchSegment& ExportTable = Segments.AddDefaulted_GetRef();
+		ExportTable.Start = ExportOffset;
+		ExportTable.End = Reader.ExportsEnd;
+		FRetargetPackageWriter Writer{ ExportTable.Bytes, NameMap, Reader };
+		for (FObjectExport& Export : Reader.Exports)
+		{
+			Writer << Export;
+		}
+	}
+	if (Thumbnails.End > Thumbnails.Start)
+	{
+		Segments.Add(MoveTemp(Thumbnails));
+	}
+
+	// Rebuild the file, copying untouched ranges as they are
+	Segments.Sort([](const FPatchSegment& A, const FPatchSegment& B) {
+		return A.Start < B.Start || (A.Start == B.Start && A.End < B.End);
+	});
+
+	TArray<uint8> Patched;
+	Patched.Reserve(Original.Num() + 1024);
+	int64 Position = 0;
+	for (const FPatchSegment& Segment : Segments)
+	{
+		if (Segment.Start < Position)
+		{
+			OutError = TEXT("Package tables overlap");
+			return false;
+		}
+		Patched.Append(Original.GetData() + Position, Segment.Start - Position);
+		Patched.Append(Segment.Bytes);
+		Position = Segment.End;
+	}
+	Patched.Append(Original.GetData() + Position, Original.Num() - Position);
+
+	// Read the result back before replacing the original
+	FRetargetPackageReader Check;
+	if (!Check.Open(Patched) || !Check.ReadTables() || Check.GetImportPath(ClassIndex) != NewParent->GetPathName())
+	{
+		OutError = TEXT("Patched package can't be read back");
+		return false;
+	}
+
+	const FString TempFilename = Filename + TEXT(".retarget");
+	if (!FFileHelper::SaveArrayToFile(Patched, *TempFilename) || !IFileManager::Get().Move(*Filename, *TempFilename, true, true))
+	{
+		IFileManager::Get().Delete(*TempFilename, false, true, true);
+		OutError = TEXT("Couldn't write the package");
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,23 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+class UClass;
+
+
+/**
+ * Retargets blueprints by rewriting the parent class import of their package file, without loading them.
+ * Only valid if the new parent has the same layout as the old one (E.g: a class moved to another module).
+ * The blueprint recompiles against its new parent the next time it loads.
+ */
+struct FRetargetPackagePatcher
+{
+	/**
+	 * Points the import of the old parent class (and its default object) to the new parent.
+	 * The package is rewritten only if its tables serialize back exactly as they were read.
+	 * @return true if the file was patched. OutError explains why otherwise
+	 */
+	static bool PatchParentClass(const FString& Filename, const FString& OldParentPath, const UClass* NewParent, FString& OutError);
+};
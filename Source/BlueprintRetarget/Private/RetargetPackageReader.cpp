@@ -0,0 +1,206 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetPackageReader.h"
+
+#include <HAL/FileManager.h>
+#include <HAL/PlatformFilemanager.h>
+#include <Async/MappedFileHandle.h>
+#include <Serialization/LargeMemoryReader.h>
+#include <Serialization/MemoryReader.h>
+
+
+FRetargetPackageReader::FRetargetPackageReader()
+{
+	SetIsLoading(true);
+	SetIsPersistent(true);
+}
+
+FRetargetPackageReader::~FRetargetPackageReader()
+{
+	// The reader must be released before the memory it reads
+	Loader.Reset();
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+}
+
+bool FRetargetPackageReader::Open(const FString& Filename)
+{
+	// Mapping avoids copying the whole file when only its header is needed
+	MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedHandle)
+	{
+		MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+	}
+
+	if (MappedRegion)
+	{
+		Loader = MakeUnique<FLargeMemoryReader>(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+	}
+	else
+	{
+		Loader.Reset(IFileManager::Get().CreateFileReader(*Filename, FILEREAD_Silent));
+	}
+	return Loader.IsValid();
+}
+
+bool FRetargetPackageReader::Open(const TArray<uint8>& Bytes)
+{
+	Loader = MakeUnique<FMemoryReader>(Bytes);
+	return true;
+}
+
+bool FRetargetPackageReader::ReadTables()
+{
+	*this << Summary;
+	if (IsError() || Summary.Tag != PACKAGE_FILE_TAG || Summary.GetFileVersionUE4() < VER_UE4_OLDEST_LOADABLE_PACKAGE)
+	{
+		return false;
+	}
+	SummaryEnd = Tell();
+
+	const int64 Size = TotalSize();
+	if (Summary.NameCount < 0 || Summary.NameOffset > Size || Summary.ImportCount < 0 || Summary.ImportOffset > Size ||
+		Summary.ExportCount < 0 || Summary.ExportOffset > Size)
+	{
+		return false;
+	}
+
+	SetUE4Ver(Summary.GetFileVersionUE4());
+	SetLicenseeUE4Ver(Summary.GetFileVersionLicenseeUE4());
+	SetEngineVer(Summary.SavedByEngineVersion);
+	SetCustomVersions(Summary.GetCustomVersionContainer());
+
+	Seek(Summary.NameOffset);
+	NameMap.Reserve(Summary.NameCount);
+	for (int32 I = 0; I < Summary.NameCount && !IsError(); ++I)
+	{
+		FNameEntrySerialized NameEntry(ENAME_LinkerConstructor);
+		*this << NameEntry;
+		NameMap.Add(FName(NameEntry));
+	}
+	NameMapEnd = Tell();
+
+	Seek(Summary.ImportOffset);
+	Imports.SetNum(Summary.ImportCount);
+	for (int32 I = 0; I < Summary.ImportCount && !IsError(); ++I)
+	{
+		*this << Imports[I];
+	}
+	ImportsEnd = Tell();
+
+	Seek(Summary.ExportOffset);
+	Exports.SetNum(Summary.ExportCount);
+	for (int32 I = 0; I < Summary.ExportCount && !IsError(); ++I)
+	{
+		*this << Exports[I];
+	}
+	ExportsEnd = Tell();
+	return !IsError();
+}
+
+FString FRetargetPackageReader::GetImportPath(int32 ImportIndex) const
+{
+	FString Path = Imports[ImportIndex].ObjectName.ToString();
+	FPackageIndex Outer = Imports[ImportIndex].OuterIndex;
+
+	// Depth is limited in case the table is corrupted
+	for (int32 Depth = 0; Outer.IsImport() && Imports.IsValidIndex(Outer.ToImport()) && Depth < 16; ++Depth)
+	{
+		const FObjectImport& OuterImport = Imports[Outer.ToImport()];
+
+		// Objects directly inside a package are separated by '.', subobjects by ':'
+		const TCHAR* Separator = OuterImport.OuterIndex.IsNull() ? TEXT(".") : TEXT(":");
+		Path = OuterImport.ObjectName.ToString() + Separator + Path;
+		Outer = OuterImport.OuterIndex;
+	}
+	return Path;
+}
+
+FArchive& FRetargetPackageReader::operator<<(FName& Name)
+{
+	int32 NameIndex = 0;
+	int32 Number = 0;
+	*this << NameIndex << Number;
+
+	if (NameMap.IsValidIndex(NameIndex))
+	{
+		Name = FName(NameMap[NameIndex], Number);
+	}
+	else
+	{
+		Name = NAME_None;
+		SetError();
+	}
+	return *this;
+}
+
+void FRetargetPackageReader::Serialize(void* Data, int64 Length)
+{
+	Loader->Serialize(Data, Length);
+	if (Loader->IsError())
+	{
+		SetError();
+	}
+}
+
+void FRetargetPackageReader::Seek(int64 Position)
+{
+	Loader->Seek(Position);
+}
+
+int64 FRetargetPackageReader::Tell()
+{
+	return Loader->Tell();
+}
+
+int64 FRetargetPackageReader::TotalSize()
+{
+	return Loader->TotalSize();
+}
+
+
+FRetargetPackageWriter::FRetargetPackageWriter(TArray<uint8>& InBytes, TArray<FName>& InNameMap, FRetargetPackageReader& Reader)
+	: Bytes(InBytes)
+	, NameMap(InNameMap)
+{
+	SetIsSaving(true);
+	SetIsPersistent(true);
+	SetUE4Ver(Reader.UE4Ver());
+	SetLicenseeUE4Ver(Reader.LicenseeUE4Ver());
+	SetEngineVer(Reader.EngineVer());
+	SetCustomVersions(Reader.GetCustomVersions());
+
+	for (int32 Index = 0; Index < NameMap.Num(); ++Index)
+	{
+		NameIndices.Add(NameMap[Index], Index);
+	}
+}
+
+int32 FRetargetPackageWriter::AddName(FName Name)
+{
+	// The map holds names without their number
+	const FName BaseName{ Name, NAME_NO_NUMBER_INTERNAL };
+	if (const int32* Index = NameIndices.Find(BaseName))
+	{
+		return *Index;
+	}
+	return NameIndices.Add(BaseName, NameMap.Add(BaseName));
+}
+
+FArchive& FRetargetPackageWriter::operator<<(FName& Name)
+{
+	int32 NameIndex = AddName(Name);
+	int32 Number = Name.GetNumber();
+	*this << NameIndex << Number;
+	return *this;
+}
+
+void FRetargetPackageWriter::Serialize(void* Data, int64 Length)
+{
+	if (Offset + Length > Bytes.Num())
+	{
+		Bytes.AddUninitialized(Offset + Length - Bytes.Num());
+	}
+	FMemory::Memcpy(Bytes.GetData() + Offset, Data, Length);
+	Offset += Length;
+}
@@ -0,0 +1,81 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Serialization/ArchiveUObject.h>
+#include <UObject/ObjectResource.h>
+#include <UObject/PackageFileSummary.h>
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+
+/** Reads the tables of a package file, resolving names from the package's own name map */
+class FRetargetPackageReader : public FArchiveUObject
+{
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TUniquePtr<FArchive> Loader;
+
+
+public:
+	FPackageFileSummary Summary;
+	TArray<FName> NameMap;
+	TArray<FObjectImport> Imports;
+	TArray<FObjectExport> Exports;
+
+	/** Where each table ends in the file */
+	int64 SummaryEnd = 0;
+	int64 NameMapEnd = 0;
+	int64 ImportsEnd = 0;
+	int64 ExportsEnd = 0;
+
+
+	FRetargetPackageReader();
+	virtual ~FRetargetPackageReader();
+
+	/** Opens a package file, memory mapped if the platform supports it */
+	bool Open(const FString& Filename);
+
+	/** Reads a package already in memory */
+	bool Open(const TArray<uint8>& Bytes);
+
+	bool ReadTables();
+
+	/** @return object path of an import. E.g: /Script/Engine.Actor */
+	FString GetImportPath(int32 ImportIndex) const;
+
+	using FArchiveUObject::operator<<;
+	virtual FArchive& operator<<(FName& Name) override;
+	virtual void Serialize(void* Data, int64 Length) override;
+	virtual void Seek(int64 Position) override;
+	virtual int64 Tell() override;
+	virtual int64 TotalSize() override;
+};
+
+
+/** Writes package tables, storing names as indices of a name map. New names are added to the end of the map */
+class FRetargetPackageWriter : public FArchiveUObject
+{
+	TArray<uint8>& Bytes;
+	int64 Offset = 0;
+
+	TArray<FName>& NameMap;
+	TMap<FName, int32> NameIndices;
+
+
+public:
+	/** @param Reader package whose versions are used */
+	FRetargetPackageWriter(TArray<uint8>& InBytes, TArray<FName>& InNameMap, FRetargetPackageReader& Reader);
+
+	/** @return index of a name in the name map, adding it if needed */
+	int32 AddName(FName Name);
+
+	using FArchiveUObject::operator<<;
+	virtual FArchive& operator<<(FName& Name) override;
+	virtual void Serialize(void* Data, int64 Length) override;
+	virtual void Seek(int64 Position) override { Offset = Position; }
+	virtual int64 Tell() override { return Offset; }
+	virtual int64 TotalSize() override { return Bytes.Num(); }
+};
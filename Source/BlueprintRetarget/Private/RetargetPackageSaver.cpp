@@ -0,0 +1,204 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetPackageSaver.h"
+#include "BlueprintRetarget.h"
+#include "RetargetStats.h"
+
+#include <HAL/FileManager.h>
+#include <HAL/PlatformFilemanager.h>
+#include <ISourceControlModule.h>
+#include <ISourceControlProvider.h>
+#include <Misc/PackageName.h>
+#include <Misc/Paths.h>
+#include <SourceControlOperations.h>
+#include <UObject/Package.h>
+
+
+TMap<FName, FString> FRetargetPackageSaver::CheckOut(const TArray<FName>& PackageNames)
+{
+	TMap<FString, FName> PackagesByFile;
+	TArray<FString> Filenames;
+	for (const FName& PackageName : PackageNames)
+	{
+		const FString Filename = GetPackageFilename(PackageName);
+		PackagesByFile.Add(Filename, PackageName);
+		Filenames.Add(Filename);
+	}
+
+	TMap<FName, FString> Failed;
+	for (const auto& Failure : CheckOutFiles(Filenames))
+	{
+		Failed.Add(PackagesByFile.FindChecked(Failure.Key), Failure.Value);
+	}
+	return Failed;
+}
+
+TMap<FString, FString> FRetargetPackageSaver::CheckOutFiles(const TArray<FString>& Filenames)
+{
+	RETARGET_PHASE_SCOPE(CheckOut, NAME_None);
+
+	TMap<FString, FString> Failed;
+	if (Filenames.Num() <= 0)
+	{
+		return Failed;
+	}
+
+	// Source control works with absolute paths
+	TMap<FString, FString> FilesByFullPath;
+	TArray<FString> FullPaths;
+	for (const FString& Filename : Filenames)
+	{
+		const FString FullPath = FPaths::ConvertRelativePathToFull(Filename);
+		FilesByFullPath.Add(FullPath, Filename);
+		FullPaths.Add(FullPath);
+	}
+
+	ISourceControlModule& SourceControl = ISourceControlModule::Get();
+	if (SourceControl.IsEnabled() && SourceControl.GetProvider().IsAvailable())
+	{
+		ISourceControlProvider& Provider = SourceControl.GetProvider();
+
+		TArray<FSourceControlStateRef> States;
+		if (Provider.GetState(FullPaths, States, EStateCacheUsage::ForceUpdate) != ECommandResult::Succeeded)
+		{
+			UE_LOG(LogBlueprintReparent, Warning, TEXT("Couldn't get the source control state of %i files"), FullPaths.Num());
+		}
+
+		TArray<FString> ToCheckOut;
+		for (const FSourceControlStateRef& State : States)
+		{
+			const FString* Filename = FilesByFullPath.Find(State->GetFilename());
+			if (!Filename || State->IsCheckedOut() || State->IsAdded())
+			{
+				continue;
+			}
+
+			FString Who;
+			if (State->IsCheckedOutOther(&Who))
+			{
+				Failed.Add(*Filename, FString::Printf(TEXT("Checked out by %s"), *Who));
+			}
+			else if (State->IsSourceControlled() && !State->IsCurrent())
+			{
+				Failed.Add(*Filename, TEXT("Not at the latest revision"));
+			}
+			else if (State->CanCheckout())
+			{
+				ToCheckOut.Add(State->GetFilename());
+			}
+		}
+
+		if (ToCheckOut.Num() > 0)
+		{
+			UE_LOG(LogBlueprintReparent, Log, TEXT("Checking out %i files"), ToCheckOut.Num());
+			Provider.Execute(ISourceControlOperation::Create<FCheckOut>(), ToCheckOut);
+
+			// A failed request may still have checked out some of them
+			Provider.GetState(ToCheckOut, States, EStateCacheUsage::Use);
+			for (const FSourceControlStateRef& State : States)
+			{
+				if (!State->IsCheckedOut())
+				{
+					Failed.Add(FilesByFullPath.FindChecked(State->GetFilename()), TEXT("Check out failed"));
+				}
+			}
+		}
+	}
+
+	// Files not under source control only need to be writable
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	for (const FString& FullPath : FullPaths)
+	{
+		const FString& Filename = FilesByFullPath.FindChecked(FullPath);
+		if (!Failed.Contains(Filename) && PlatformFile.IsReadOnly(*FullPath) && !PlatformFile.SetReadOnly(*FullPath, false))
+		{
+			Failed.Add(Filename, TEXT("File is read only"));
+		}
+	}
+
+	for (const auto& Failure : Failed)
+	{
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("Can't write %s: %s"), *Failure.Key, *Failure.Value);
+	}
+	return Failed;
+}
+
+FRetargetSaveResult FRetargetPackageSaver::Save(const TArray<UPackage*>& Packages)
+{
+	FRetargetSaveResult Result;
+	for (UPackage* Package : Packages)
+	{
+		RETARGET_PHASE_SCOPE(Save, Package);
+
+		const FString Filename = GetPackageFilename(Package->GetFName());
+		FString Failure;
+		if (!CanWriteFile(Filename, Failure))
+		{
+			Result.Failed.Add(Package, Failure);
+			continue;
+		}
+
+		// Serialization must happen on the game thread. Writing the file doesn't
+		const FSavePackageResultStruct SaveResult = UPackage::Save(Package, nullptr, RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError | SAVE_Async);
+		if (SaveResult.Result != ESavePackageResult::Success)
+		{
+			Result.Failed.Add(Package, TEXT("Couldn't serialize the package"));
+			continue;
+		}
+		Result.Saved.Add(Package);
+		INC_DWORD_STAT(STAT_BlueprintRetarget_NumSaved);
+	}
+
+	// Files were checked to be writable before. Async writes don't report a result per package
+	{
+		RETARGET_PHASE_SCOPE(Save, NAME_None);
+		UPackage::WaitForAsyncFileWrites();
+	}
+
+	for (const auto& Failure : Result.Failed)
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Failed to save %s: %s"), *Failure.Key->GetName(), *Failure.Value);
+	}
+	UE_LOG(LogBlueprintReparent, Log, TEXT("Saved %i of %i packages"), Result.Saved.Num(), Packages.Num());
+	return Result;
+}
+
+bool FRetargetPackageSaver::CanWriteFile(const FString& Filename, FString& OutFailure)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString Directory = FPaths::GetPath(Filename);
+	if (!PlatformFile.DirectoryExists(*Directory) && !PlatformFile.CreateDirectoryTree(*Directory))
+	{
+		OutFailure = TEXT("Directory can't be created");
+		return false;
+	}
+
+	if (!PlatformFile.FileExists(*Filename))
+	{
+		return true;
+	}
+	if (PlatformFile.IsReadOnly(*Filename))
+	{
+		OutFailure = TEXT("File is read only");
+		return false;
+	}
+
+	// Permissions or another process can still prevent writing. Opening it to append doesn't modify it
+	TUniquePtr<IFileHandle> Handle{ PlatformFile.OpenWrite(*Filename, true) };
+	if (!Handle)
+	{
+		OutFailure = TEXT("File can't be opened for writing");
+		return false;
+	}
+	return true;
+}
+
+FString FRetargetPackageSaver::GetPackageFilename(FName PackageName)
+{
+	FString Filename;
+	if (!FPackageName::DoesPackageExist(PackageName.ToString(), nullptr, &Filename))
+	{
+		Filename = FPackageName::LongPackageNameToFilename(PackageName.ToString(), FPackageName::GetAssetPackageExtension());
+	}
+	return Filename;
+}
@@ -0,0 +1,47 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+class UPackage;
+
+
+struct FRetargetSaveResult
+{
+	TArray<UPackage*> Saved;
+
+	/** Package -> Reason it couldn't be saved */
+	TMap<UPackage*, FString> Failed;
+};
+
+
+/**
+ * Writes retargeted packages in batches instead of one by one through the editor save prompt.
+ * Files are checked out with a single source control request, and written while the next package serializes.
+ */
+struct FRetargetPackageSaver
+{
+	/**
+	 * Checks out the files of all packages under source control in one request. Other files are made writable.
+	 * Works with source control disabled too.
+	 * @return package name -> reason, for packages whose file can't be written
+	 */
+	static TMap<FName, FString> CheckOut(const TArray<FName>& PackageNames);
+
+	/** Same as CheckOut, for any file (E.g: config files). @return filename -> reason, for files that can't be written */
+	static TMap<FString, FString> CheckOutFiles(const TArray<FString>& Filenames);
+
+	/**
+	 * Saves packages to their files. Packages are serialized one after another, but their files get written
+	 * asynchronously, in parallel. A package that fails doesn't stop the rest.
+	 * Files are checked to be writable first, since a failed async write can't be reported per package.
+	 */
+	static FRetargetSaveResult Save(const TArray<UPackage*>& Packages);
+
+	/** @return true if the file (or a new file at that path) can be written. OutFailure explains why otherwise */
+	static bool CanWriteFile(const FString& Filename, FString& OutFailure);
+
+	/** @return the file of an existing package, or where a new asset package would go */
+	static FString GetPackageFilename(FName PackageName);
+};
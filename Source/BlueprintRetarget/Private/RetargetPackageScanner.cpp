@@ -0,0 +1,139 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetPackageScanner.h"
+#include "BlueprintRetarget.h"
+#include "RetargetUtils.h"
+#include "RetargetPackageReader.h"
+
+#include <Async/ParallelFor.h>
+#include <HAL/FileManager.h>
+#include <Misc/PackageName.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+
+
+TArray<FScannedBlueprint> FRetargetPackageScanner::FindBrokenBlueprints(const FString& RootPath)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BlueprintRetarget_ScanPackages);
+	const double StartTime = FPlatformTime::Seconds();
+
+	FString RootDirectory;
+	if (!FPackageName::TryConvertLongPackageNameToFilename(RootPath / TEXT(""), RootDirectory))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("'%s' is not a mounted content path"), *RootPath);
+		return {};
+	}
+
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFilesRecursive(Filenames, *RootDirectory, *(FString(TEXT("*")) + FPackageName::GetAssetPackageExtension()), true, false);
+
+	// Package names are resolved before going parallel. Mount points are not thread safe
+	TArray<FScannedBlueprint> Packages;
+	Packages.Reserve(Filenames.Num());
+	for (const FString& Filename : Filenames)
+	{
+		FString PackageName;
+		if (FPackageName::TryConvertFilenameToLongPackageName(Filename, PackageName))
+		{
+			FScannedBlueprint& Package = Packages.AddDefaulted_GetRef();
+			Package.PackageName = FName(*PackageName);
+			Package.Filename = Filename;
+		}
+	}
+
+	TArray<bool> IsBlueprint;
+	IsBlueprint.SetNumZeroed(Packages.Num());
+	ParallelFor(Packages.Num(), [&Packages, &IsBlueprint](int32 Index)
+	{
+		FScannedBlueprint& Package = Packages[Index];
+		IsBlueprint[Index] = ReadParentClassPath(Package.Filename, Package.PackageName.ToString(), Package.ParentClassPath);
+	});
+
+	// Parents are resolved on the game thread. Most blueprints share a few of them
+	TMap<FString, bool> ResolvedParents;
+	TArray<FScannedBlueprint> Broken;
+	int32 NumBlueprints = 0;
+	for (int32 Index = 0; Index < Packages.Num(); ++Index)
+	{
+		if (!IsBlueprint[Index])
+		{
+			continue;
+		}
+		++NumBlueprints;
+
+		const FString& ParentClassPath = Packages[Index].ParentClassPath;
+		const bool* bResolved = ResolvedParents.Find(ParentClassPath);
+		if (!bResolved)
+		{
+			bResolved = &ResolvedParents.Add(ParentClassPath, IsParentResolved(ParentClassPath));
+		}
+
+		if (!*bResolved)
+		{
+			Broken.Add(MoveTemp(Packages[Index]));
+		}
+	}
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Scanned %i packages (%i blueprints) in %.2fs. Found %i broken blueprints"),
+		Packages.Num(), NumBlueprints, FPlatformTime::Seconds() - StartTime, Broken.Num());
+	return Broken;
+}
+
+bool FRetargetPackageScanner::ReadParentClassPath(const FString& Filename, const FString& PackageName, FString& OutParentClassPath)
+{
+	FRetargetPackageReader Reader;
+	if (!Reader.Open(Filename) || !Reader.ReadTables())
+	{
+		return false;
+	}
+	const TArray<FObjectImport>& Imports = Reader.Imports;
+	const TArray<FObjectExport>& Exports = Reader.Exports;
+
+	// The class generated by the blueprint is what holds the parent, as its super class
+	const FName GeneratedClassName{ *(FPackageName::GetShortName(PackageName) + TEXT("_C")) };
+	for (const FObjectExport& Export : Exports)
+	{
+		if (Export.ObjectName != GeneratedClassName || !Export.OuterIndex.IsNull() ||
+			!Export.ClassIndex.IsImport() || !Imports.IsValidIndex(Export.ClassIndex.ToImport()))
+		{
+			continue;
+		}
+
+		// Blueprint, Widget, Anim... generated classes
+		if (!Imports[Export.ClassIndex.ToImport()].ObjectName.ToString().EndsWith(TEXT("GeneratedClass")))
+		{
+			continue;
+		}
+
+		if (Export.SuperIndex.IsImport() && Imports.IsValidIndex(Export.SuperIndex.ToImport()))
+		{
+			OutParentClassPath = Reader.GetImportPath(Export.SuperIndex.ToImport());
+		}
+		else if (Export.SuperIndex.IsExport() && Exports.IsValidIndex(Export.SuperIndex.ToExport()))
+		{
+			OutParentClassPath = PackageName + TEXT(".") + Exports[Export.SuperIndex.ToExport()].ObjectName.ToString();
+		}
+		else
+		{
+			OutParentClassPath.Empty();
+		}
+		return true;
+	}
+	return false;
+}
+
+bool FRetargetPackageScanner::IsParentResolved(const FString& ParentClassPath)
+{
+	if (ParentClassPath.IsEmpty())
+	{
+		return false;
+	}
+
+	if (FRetargetUtils::IsClassPathResolved(ParentClassPath))
+	{
+		return true;
+	}
+
+	// Asset registry can be outdated (E.g: after a sync). The file is enough for parent blueprints
+	const FString ParentPackage = FPackageName::ObjectPathToPackageName(ParentClassPath);
+	return !FPackageName::IsScriptPackage(ParentPackage) && FPackageName::DoesPackageExist(ParentPackage);
+}
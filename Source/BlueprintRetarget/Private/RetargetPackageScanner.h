@@ -0,0 +1,40 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+/** A blueprint package found by the scanner */
+struct FScannedBlueprint
+{
+	FName PackageName;
+	FString Filename;
+
+	/** Object path of the parent class import. Empty if the generated class has no parent */
+	FString ParentClassPath;
+};
+
+
+/**
+ * Finds broken blueprints reading package files directly, without loading them or trusting asset registry tags.
+ * Only the summary, name map, imports and exports of each package are read, in parallel.
+ */
+struct FRetargetPackageScanner
+{
+	/**
+	 * Scans all packages under a content path (E.g: /Game)
+	 * @return blueprints whose parent class can't be resolved
+	 */
+	static TArray<FScannedBlueprint> FindBrokenBlueprints(const FString& RootPath);
+
+	/**
+	 * Reads the parent of the class generated by a blueprint package, from its import table.
+	 * Thread safe.
+	 * @return true if the package contains a blueprint
+	 */
+	static bool ReadParentClassPath(const FString& Filename, const FString& PackageName, FString& OutParentClassPath);
+
+	/** Like FRetargetUtils::IsClassPathResolved, but also finds parent blueprints missing on the asset registry */
+	static bool IsParentResolved(const FString& ParentClassPath);
+};
@@ -0,0 +1,228 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetRedirects.h"
+#include "BlueprintRetarget.h"
+#include "RetargetBlueprintFilter.h"
+#include "RetargetPackageReader.h"
+#include "RetargetPackageSaver.h"
+#include "RetargetSuggestions.h"
+#include "RetargetUtils.h"
+
+#include <AssetData.h>
+#include <Engine/Blueprint.h>
+#include <Misc/FileHelper.h>
+#include <Misc/PackageName.h>
+#include <Misc/Paths.h>
+#include <UObject/CoreRedirects.h>
+#include <UObject/Package.h>
+#include <UObject/UObjectIterator.h>
+
+
+UClass* FRetargetRedirects::FindMovedClass(const FString& MissingClassPath)
+{
+	// If no name exists, no class can have it
+	const FName ClassName{ *GetClassName(MissingClassPath), FNAME_Find };
+	if (ClassName.IsNone())
+	{
+		return nullptr;
+	}
+
+	UClass* MovedClass = nullptr;
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		if (Class->GetFName() != ClassName ||
+			Class->HasAnyClassFlags(CLASS_Deprecated | CLASS_NewerVersionExists) ||
+			Class->GetOutermost() == GetTransientPackage())
+		{
+			continue;
+		}
+
+		if (MovedClass)
+		{
+			// More than one candidate, we can't tell which one it was moved to
+			return nullptr;
+		}
+		MovedClass = Class;
+	}
+	return MovedClass;
+}
+
+bool FRetargetRedirects::HaveSameName(const FString& ClassPathA, const FString& ClassPathB)
+{
+	return GetClassName(ClassPathA) == GetClassName(ClassPathB);
+}
+
+bool FRetargetRedirects::HasMatchingLayout(const UClass* Class, const TArray<FAssetData>& Blueprints)
+{
+	if (!Class)
+	{
+		return false;
+	}
+
+	TSharedRef<FRetargetBlueprintFilter> Filter = FRetargetBlueprintFilter::Create(Blueprints);
+	if (!Filter->IsClassEligible(Class))
+	{
+		return false;
+	}
+
+	// A matching name is not enough. Each blueprint must show it finds on the class what it used from the old one
+	FParentMemberUsage Usage;
+	for (const FAssetData& AssetData : Blueprints)
+	{
+		if (AssetData.IsAssetLoaded())
+		{
+			Usage.Gather(Cast<UBlueprint>(AssetData.FastGetAsset(false)));
+		}
+		else if (!HasImportedMembers(Class, AssetData))
+		{
+			return false;
+		}
+	}
+	return Usage.Num() <= 0 || Usage.Match(Class) >= 1.f;
+}
+
+bool FRetargetRedirects::AddClassRedirect(const FString& OldClassPath, const FString& NewClassPath)
+{
+	if (IsRedirected(OldClassPath))
+	{
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("Class %s is already redirected"), *OldClassPath);
+		return false;
+	}
+
+	// A redirect only active during this session would leave the blueprints broken on the next one
+	if (!SaveClassRedirect(OldClassPath, NewClassPath))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't save redirect of class %s to %s"), *OldClassPath, *NewClassPath);
+		return false;
+	}
+
+	TArray<FCoreRedirect> Redirects;
+	Redirects.Emplace(ECoreRedirectFlags::Type_Class, OldClassPath, NewClassPath);
+	if (!FCoreRedirects::AddRedirectList(Redirects, TEXT("BlueprintRetarget")))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't redirect class %s to %s"), *OldClassPath, *NewClassPath);
+		return false;
+	}
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Redirected class %s to %s"), *OldClassPath, *NewClassPath);
+	return true;
+}
+
+bool FRetargetRedirects::IsRedirected(const FString& ClassPath)
+{
+	const FCoreRedirectObjectName OldName{ ClassPath };
+	return FCoreRedirects::GetRedirectedName(ECoreRedirectFlags::Type_Class, OldName) != OldName;
+}
+
+bool FRetargetRedirects::HasImportedMembers(const UClass* Class, const FAssetData& AssetData)
+{
+	// Unloaded blueprints are not loaded to find out, only the tables of their package are read
+	FString Filename;
+	FRetargetPackageReader Reader;
+	if (!FPackageName::DoesPackageExist(AssetData.PackageName.ToString(), nullptr, &Filename) || !Reader.Open(Filename) || !Reader.ReadTables())
+	{
+		UE_LOG(LogBlueprintReparent, Warning, TEXT("Couldn't read '%s'. Its parent won't be redirected"), *AssetData.PackageName.ToString());
+		return false;
+	}
+
+	const FString OldPath = FPackageName::ExportTextPathToObjectPath(FRetargetUtils::GetParentClassPath(AssetData));
+	const TArray<FObjectImport>& Imports = Reader.Imports;
+	int32 ClassIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < Imports.Num(); ++Index)
+	{
+		if (Reader.GetImportPath(Index) == OldPath)
+		{
+			ClassIndex = Index;
+			break;
+		}
+	}
+	if (ClassIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FPackageIndex OldClass = FPackageIndex::FromImport(ClassIndex);
+	const FName OldDefaultName{ *(DEFAULT_OBJECT_PREFIX + Imports[ClassIndex].ObjectName.ToString()) };
+	const int32 DefaultIndex = Imports.IndexOfByPredicate([&](const FObjectImport& Import) {
+		return Import.OuterIndex == Imports[ClassIndex].OuterIndex && Import.ObjectName == OldDefaultName;
+	});
+	const FPackageIndex OldDefault = DefaultIndex != INDEX_NONE ? FPackageIndex::FromImport(DefaultIndex) : FPackageIndex{};
+
+	// Functions called or overridden and inherited components are imported from the old class. Variables are not objects
+	UObject* Default = Class->GetDefaultObject();
+	for (const FObjectImport& Import : Imports)
+	{
+		bool bFound = true;
+		if (Import.OuterIndex == OldClass)
+		{
+			bFound = Import.ClassName == NAME_Function ?
+				Class->FindFunctionByName(Import.ObjectName) != nullptr :
+				StaticFindObjectFast(nullptr, const_cast<UClass*>(Class), Import.ObjectName) != nullptr;
+		}
+		else if (!OldDefault.IsNull() && Import.OuterIndex == OldDefault)
+		{
+			bFound = StaticFindObjectFast(nullptr, Default, Import.ObjectName) != nullptr;
+		}
+
+		if (!bFound)
+		{
+			UE_LOG(LogBlueprintReparent, Log, TEXT("%s uses %s, which %s doesn't have"), *AssetData.PackageName.ToString(), *Import.ObjectName.ToString(), *Class->GetPathName());
+			return false;
+		}
+	}
+	return true;
+}
+
+FString FRetargetRedirects::GetClassName(const FString& ClassPath)
+{
+	return FPackageName::ObjectPathToObjectName(FPackageName::ExportTextPathToObjectPath(ClassPath));
+}
+
+bool FRetargetRedirects::SaveClassRedirect(const FString& OldClassPath, const FString& NewClassPath)
+{
+	const FString IniPath = FPaths::ProjectConfigDir() / TEXT("DefaultEngine.ini");
+	const FString Entry = FString::Printf(TEXT("+ClassRedirects=(OldName=\"%s\",NewName=\"%s\")"), *OldClassPath, *NewClassPath);
+
+	// A missing file is fine, it will be created
+	TArray<FString> Lines;
+	FFileHelper::LoadFileToStringArray(Lines, *IniPath);
+	if (Lines.Contains(Entry))
+	{
+		return true;
+	}
+
+	const int32 SectionIndex = Lines.IndexOfByPredicate([](const FString& Line) {
+		return Line.TrimStartAndEnd() == TEXT("[CoreRedirects]");
+	});
+
+	if (SectionIndex == INDEX_NONE)
+	{
+		if (Lines.Num() > 0 && !Lines.Last().TrimStartAndEnd().IsEmpty())
+		{
+			Lines.Add(FString{});
+		}
+		Lines.Add(TEXT("[CoreRedirects]"));
+		Lines.Add(Entry);
+	}
+	else
+	{
+		// Add after the last entry of the section
+		int32 InsertIndex = SectionIndex + 1;
+		for (int32 I = SectionIndex + 1; I < Lines.Num() && !Lines[I].TrimStart().StartsWith(TEXT("[")); ++I)
+		{
+			if (!Lines[I].TrimStartAndEnd().IsEmpty())
+			{
+				InsertIndex = I + 1;
+			}
+		}
+		Lines.Insert(Entry, InsertIndex);
+	}
+
+	// Checked out like any other file, so that the redirect gets submitted
+	if (FRetargetPackageSaver::CheckOutFiles({ IniPath }).Num() > 0)
+	{
+		return false;
+	}
+	return FFileHelper::SaveStringArrayToFile(Lines, *IniPath);
+}
@@ -0,0 +1,46 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+struct FAssetData;
+class UClass;
+
+
+/**
+ * Fixes blueprints whose parent was only renamed or moved by redirecting the old class path.
+ * Blueprints resolve the redirect when they load, so they don't need to be loaded, compiled or saved.
+ */
+struct FRetargetRedirects
+{
+	/** @return the only loaded class with the same name as a missing class, in another package */
+	static UClass* FindMovedClass(const FString& MissingClassPath);
+
+	/** @return true if both class paths have the same class name. E.g: /Script/Old.MyActor and /Script/New.MyActor */
+	static bool HaveSameName(const FString& ClassPathA, const FString& ClassPathB);
+
+	/**
+	 * @return true if the class can replace the missing parent of all the blueprints.
+	 * Every blueprint must find on the class the members it uses from its parent: gathered from its graphs if loaded,
+	 * or from the import table of its package otherwise. A blueprint that can't be inspected fails the match.
+	 */
+	static bool HasMatchingLayout(const UClass* Class, const TArray<FAssetData>& Blueprints);
+
+	/**
+	 * Saves a class redirect on the project's DefaultEngine.ini under [CoreRedirects], and registers it.
+	 * The config file is checked out first. Nothing is redirected if it can't be.
+	 * @return true if the redirect was saved and is active
+	 */
+	static bool AddClassRedirect(const FString& OldClassPath, const FString& NewClassPath);
+
+	/** @return true if the class path is already redirected somewhere else */
+	static bool IsRedirected(const FString& ClassPath);
+
+private:
+	/** @return true if the unloaded blueprint's package imports nothing from its missing parent that the class lacks */
+	static bool HasImportedMembers(const UClass* Class, const FAssetData& AssetData);
+
+	static FString GetClassName(const FString& ClassPath);
+	static bool SaveClassRedirect(const FString& OldClassPath, const FString& NewClassPath);
+};
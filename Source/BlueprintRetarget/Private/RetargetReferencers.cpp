@@ -0,0 +1,198 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetReferencers.h"
+#include "BlueprintRetarget.h"
+#include "BlueprintRetargeter.h"
+#include "RetargetUtils.h"
+
+#include <AssetRegistryModule.h>
+#include <Engine/Blueprint.h>
+#include <Misc/ScopedSlowTask.h>
+#include <UObject/UnrealType.h>
+
+
+#define LOCTEXT_NAMESPACE "BlueprintRetarget"
+
+
+FRetargetReferencers::FRetargetReferencers(const TArray<FName>& RetargetedPackages)
+	: Retargeted(RetargetedPackages)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	// Only blueprints propagate changes further. Anything else referencing them is just reported
+	TMap<FName, FAssetData> Blueprints;
+	TSet<FName> Visited = Retargeted;
+	TArray<FName> Pending = RetargetedPackages;
+	while (Pending.Num() > 0)
+	{
+		TArray<FName> Referencers;
+		AssetRegistry.GetReferencers(Pending.Pop(false), Referencers, EAssetRegistryDependencyType::Hard);
+		for (const FName& Referencer : Referencers)
+		{
+			bool bAlreadyVisited = false;
+			Visited.Add(Referencer, &bAlreadyVisited);
+			if (bAlreadyVisited)
+			{
+				continue;
+			}
+
+			TArray<FAssetData> Assets;
+			AssetRegistry.GetAssetsByPackageName(Referencer, Assets);
+			const FAssetData* Blueprint = Assets.FindByPredicate([](const FAssetData& AssetData) {
+				return FRetargetUtils::IsBlueprintAsset(AssetData);
+			});
+
+			if (Blueprint)
+			{
+				Blueprints.Add(Referencer, *Blueprint);
+				Pending.Add(Referencer);
+			}
+			else if (Assets.Num() > 0)
+			{
+				OtherReferencers.Add(Referencer);
+			}
+		}
+	}
+
+	// Dependencies outside of the closure never change
+	for (const auto& Blueprint : Blueprints)
+	{
+		TArray<FName> PackageDependencies;
+		AssetRegistry.GetDependencies(Blueprint.Key, PackageDependencies, EAssetRegistryDependencyType::Hard);
+		PackageDependencies.RemoveAll([this, &Blueprints](const FName& Dependency) {
+			return !Retargeted.Contains(Dependency) && !Blueprints.Contains(Dependency);
+		});
+		Dependencies.Add(Blueprint.Key, MoveTemp(PackageDependencies));
+	}
+
+	// Sort dependencies first. Blueprints referencing each other go in discovery order
+	TSet<FName> Sorted = Retargeted;
+	Affected.Reserve(Blueprints.Num());
+	while (Affected.Num() < Blueprints.Num())
+	{
+		const int32 LastNum = Affected.Num();
+		for (const auto& Blueprint : Blueprints)
+		{
+			if (Sorted.Contains(Blueprint.Key))
+			{
+				continue;
+			}
+
+			const bool bReady = !Dependencies[Blueprint.Key].ContainsByPredicate([&Sorted](const FName& Dependency) {
+				return !Sorted.Contains(Dependency);
+			});
+			if (bReady)
+			{
+				Sorted.Add(Blueprint.Key);
+				Affected.Add(Blueprint.Value);
+			}
+		}
+
+		if (Affected.Num() == LastNum)
+		{
+			// Only cycles are left
+			for (const auto& Blueprint : Blueprints)
+			{
+				if (!Sorted.Contains(Blueprint.Key))
+				{
+					Sorted.Add(Blueprint.Key);
+					Affected.Add(Blueprint.Value);
+					break;
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogBlueprintReparent, Log, TEXT("%i blueprints and %i other assets depend on the %i retargeted packages"),
+		Affected.Num(), OtherReferencers.Num(), Retargeted.Num());
+}
+
+FRetargetReferencersResult FRetargetReferencers::Recompile() const
+{
+	FRetargetReferencersResult Result;
+	FBlueprintRetargeter Retargeter{ false };
+
+	FScopedSlowTask SlowTask(Affected.Num(), LOCTEXT("RecompilingReferencers", "Recompiling referencers..."));
+	if (!IsRunningCommandlet())
+	{
+		SlowTask.MakeDialog(true);
+	}
+
+	// Packages whose class changed in a way their referencers can notice
+	TSet<FName> Changed = Retargeted;
+	for (const FAssetData& AssetData : Affected)
+	{
+		SlowTask.EnterProgressFrame(1.f);
+		if (SlowTask.ShouldCancel())
+		{
+			Result.bCancelled = true;
+			break;
+		}
+
+		const bool bDependencyChanged = Dependencies[AssetData.PackageName].ContainsByPredicate([&Changed](const FName& Dependency) {
+			return Changed.Contains(Dependency);
+		});
+		if (!bDependencyChanged)
+		{
+			++Result.NumSkipped;
+			continue;
+		}
+
+		UBlueprint* Blueprint = Cast<UBlueprint>(AssetData.GetAsset());
+		if (!Blueprint)
+		{
+			UE_LOG(LogBlueprintReparent, Warning, TEXT("Couldn't load %s to recompile it"), *AssetData.ObjectPath.ToString());
+			continue;
+		}
+
+		const uint32 OldSignature = GetSignature(Blueprint->GeneratedClass);
+		const bool bCompiled = Retargeter.Compile(Blueprint) && Blueprint->Status != BS_Error;
+		Result.Recompiled.Add(Blueprint);
+
+		if (!bCompiled)
+		{
+			Result.Failed.Add(Blueprint);
+			UE_LOG(LogBlueprintReparent, Error, TEXT("%s has errors after the retarget"), *AssetData.ObjectPath.ToString());
+		}
+
+		// Errors also count as changes, so that referencers get validated too
+		if (!bCompiled || GetSignature(Blueprint->GeneratedClass) != OldSignature)
+		{
+			Changed.Add(AssetData.PackageName);
+		}
+	}
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Recompiled %i referencers (%i failed, %i skipped as unchanged)"),
+		Result.Recompiled.Num(), Result.Failed.Num(), Result.NumSkipped);
+	return Result;
+}
+
+uint32 FRetargetReferencers::GetSignature(const UClass* Class)
+{
+	if (!Class)
+	{
+		return 0;
+	}
+
+	uint32 Hash = GetTypeHash(Class->GetSuperClass() ? Class->GetSuperClass()->GetPathName() : FString{});
+	for (TFieldIterator<FProperty> It(Class); It; ++It)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(It->GetFName()));
+		Hash = HashCombine(Hash, GetTypeHash(It->GetCPPType()));
+		Hash = HashCombine(Hash, GetTypeHash(It->GetOffset_ForInternal()));
+	}
+
+	for (TFieldIterator<UFunction> It(Class); It; ++It)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(It->GetFName()));
+		Hash = HashCombine(Hash, GetTypeHash(uint32(It->FunctionFlags)));
+		for (TFieldIterator<FProperty> Param(*It); Param && Param->HasAnyPropertyFlags(CPF_Parm); ++Param)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(Param->GetFName()));
+			Hash = HashCombine(Hash, GetTypeHash(Param->GetCPPType()));
+		}
+	}
+	return Hash;
+}
+
+#undef LOCTEXT_NAMESPACE
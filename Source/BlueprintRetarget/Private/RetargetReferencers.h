@@ -0,0 +1,59 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <AssetData.h>
+
+class UBlueprint;
+class UClass;
+
+
+struct FRetargetReferencersResult
+{
+	/** Blueprints recompiled because something they depend on changed */
+	TArray<UBlueprint*> Recompiled;
+
+	/** Recompiled blueprints that got errors */
+	TArray<UBlueprint*> Failed;
+
+	/** Affected blueprints whose dependencies didn't change */
+	int32 NumSkipped = 0;
+
+	bool bCancelled = false;
+};
+
+
+/**
+ * Blueprints that reference or inherit from retargeted blueprints, directly or through other blueprints.
+ * Found with the asset registry, so that only them need to be recompiled after a retarget instead of the whole project.
+ */
+class FRetargetReferencers
+{
+	TSet<FName> Retargeted;
+
+	/** Affected blueprints, sorted so that their dependencies go first */
+	TArray<FAssetData> Affected;
+
+	/** Package -> Retargeted or affected packages it depends on */
+	TMap<FName, TArray<FName>> Dependencies;
+
+	/** Packages that are not blueprints (E.g: levels) referencing affected blueprints. They can only be resaved */
+	TArray<FName> OtherReferencers;
+
+
+public:
+	FRetargetReferencers(const TArray<FName>& RetargetedPackages);
+
+	const TArray<FAssetData>& GetAffected() const { return Affected; }
+	const TArray<FName>& GetOtherReferencers() const { return OtherReferencers; }
+
+	/**
+	 * Recompiles affected blueprints in dependency order. A blueprint is skipped unless a retargeted package
+	 * or a blueprint whose signature changed when recompiled is one of its dependencies.
+	 */
+	FRetargetReferencersResult Recompile() const;
+
+	/** @return hash of the members of a class other blueprints can depend on */
+	static uint32 GetSignature(const UClass* Class);
+};
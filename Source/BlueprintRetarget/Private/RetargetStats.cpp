@@ -0,0 +1,187 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetStats.h"
+#include "BlueprintRetarget.h"
+
+#include <HAL/PlatformMemory.h>
+#include <HAL/PlatformTime.h>
+#include <Misc/FileHelper.h>
+#include <UObject/Package.h>
+
+
+DEFINE_STAT(STAT_BlueprintRetarget_Load);
+DEFINE_STAT(STAT_BlueprintRetarget_Ensure);
+DEFINE_STAT(STAT_BlueprintRetarget_RefreshNodes);
+DEFINE_STAT(STAT_BlueprintRetarget_Compile);
+DEFINE_STAT(STAT_BlueprintRetarget_GarbageCollect);
+DEFINE_STAT(STAT_BlueprintRetarget_CheckOut);
+DEFINE_STAT(STAT_BlueprintRetarget_Save);
+
+DEFINE_STAT(STAT_BlueprintRetarget_NumReparented);
+DEFINE_STAT(STAT_BlueprintRetarget_NumCompiled);
+DEFINE_STAT(STAT_BlueprintRetarget_NumSaved);
+
+DEFINE_STAT(STAT_BlueprintRetargetLLM_Load);
+DEFINE_STAT(STAT_BlueprintRetargetLLM_Ensure);
+DEFINE_STAT(STAT_BlueprintRetargetLLM_RefreshNodes);
+DEFINE_STAT(STAT_BlueprintRetargetLLM_Compile);
+DEFINE_STAT(STAT_BlueprintRetargetLLM_GarbageCollect);
+DEFINE_STAT(STAT_BlueprintRetargetLLM_CheckOut);
+DEFINE_STAT(STAT_BlueprintRetargetLLM_Save);
+
+
+static constexpr int32 NumPhases = (int32)ERetargetPhase::Num;
+
+static double ToMegabytes(uint64 Bytes)
+{
+	return double(Bytes) / (1024.0 * 1024.0);
+}
+
+
+double FRetargetPhaseRecord::GetTotalSeconds() const
+{
+	double TotalSeconds = 0.0;
+	for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+	{
+		TotalSeconds += Seconds[Phase];
+	}
+	return TotalSeconds;
+}
+
+
+FRetargetProfiler& FRetargetProfiler::Get()
+{
+	static FRetargetProfiler Instance;
+	return Instance;
+}
+
+void FRetargetProfiler::Reset()
+{
+	Records.Empty();
+	Total = {};
+}
+
+void FRetargetProfiler::Record(ERetargetPhase Phase, FName Blueprint, double Seconds, uint64 UsedMemoryAtEnd)
+{
+	const int32 Index = (int32)Phase;
+	for (FRetargetPhaseRecord* Record : { &Records.FindOrAdd(Blueprint), &Total })
+	{
+		Record->Seconds[Index] += Seconds;
+		Record->UsedMemoryAtEnd[Index] = FMath::Max(Record->UsedMemoryAtEnd[Index], UsedMemoryAtEnd);
+	}
+}
+
+void FRetargetProfiler::PrintSummary(int32 MaxRows) const
+{
+	if (IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FName> Blueprints;
+	Records.GenerateKeyArray(Blueprints);
+	Blueprints.Sort([this](const FName& A, const FName& B) {
+		return Records[A].GetTotalSeconds() > Records[B].GetTotalSeconds();
+	});
+
+	FString Header = FString::Printf(TEXT("%-60s %9s"), TEXT("Blueprint"), TEXT("Total"));
+	for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+	{
+		Header += FString::Printf(TEXT(" %14s"), GetPhaseName((ERetargetPhase)Phase));
+	}
+
+	auto FormatRow = [](const FString& Name, const FRetargetPhaseRecord& Record) {
+		FString Row = FString::Printf(TEXT("%-60s %8.3fs"), *Name.Right(60), Record.GetTotalSeconds());
+		for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+		{
+			Row += FString::Printf(TEXT(" %13.3fs"), Record.Seconds[Phase]);
+		}
+		return Row;
+	};
+
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Retarget summary, slowest %i of %i:"), FMath::Min(MaxRows, Blueprints.Num()), Blueprints.Num());
+	UE_LOG(LogBlueprintReparent, Display, TEXT("%s"), *Header);
+	for (int32 I = 0; I < Blueprints.Num() && I < MaxRows; ++I)
+	{
+		const FName Blueprint = Blueprints[I];
+		const FString Name = Blueprint.IsNone() ? TEXT("(Batched)") : Blueprint.ToString();
+		UE_LOG(LogBlueprintReparent, Display, TEXT("%s"), *FormatRow(Name, Records[Blueprint]));
+	}
+	UE_LOG(LogBlueprintReparent, Display, TEXT("%s"), *FormatRow(TEXT("Total"), Total));
+
+	FString MemoryRow = FString::Printf(TEXT("%-60s %9s"), TEXT("Used memory at end (MB)"), TEXT(""));
+	for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+	{
+		MemoryRow += FString::Printf(TEXT(" %14.1f"), ToMegabytes(Total.UsedMemoryAtEnd[Phase]));
+	}
+	UE_LOG(LogBlueprintReparent, Display, TEXT("%s"), *MemoryRow);
+}
+
+bool FRetargetProfiler::WriteCsv(const FString& Filename) const
+{
+	TArray<FString> Lines;
+	Lines.Reserve(Records.Num() + 2);
+
+	FString Header = TEXT("Blueprint,TotalSeconds");
+	for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+	{
+		const TCHAR* PhaseName = GetPhaseName((ERetargetPhase)Phase);
+		Header += FString::Printf(TEXT(",%sSeconds,%sUsedMemoryAtEndMB"), PhaseName, PhaseName);
+	}
+	Lines.Add(Header);
+
+	auto FormatLine = [](const FString& Name, const FRetargetPhaseRecord& Record) {
+		FString Line = FString::Printf(TEXT("%s,%.4f"), *Name, Record.GetTotalSeconds());
+		for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+		{
+			Line += FString::Printf(TEXT(",%.4f,%.1f"), Record.Seconds[Phase], ToMegabytes(Record.UsedMemoryAtEnd[Phase]));
+		}
+		return Line;
+	};
+
+	for (const auto& Record : Records)
+	{
+		Lines.Add(FormatLine(Record.Key.IsNone() ? TEXT("(Batched)") : Record.Key.ToString(), Record.Value));
+	}
+	Lines.Add(FormatLine(TEXT("Total"), Total));
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *Filename))
+	{
+		UE_LOG(LogBlueprintReparent, Error, TEXT("Couldn't write retarget stats to '%s'"), *Filename);
+		return false;
+	}
+	UE_LOG(LogBlueprintReparent, Display, TEXT("Retarget stats written to '%s'"), *Filename);
+	return true;
+}
+
+const TCHAR* FRetargetProfiler::GetPhaseName(ERetargetPhase Phase)
+{
+	switch (Phase)
+	{
+	case ERetargetPhase::Load:           return TEXT("Load");
+	case ERetargetPhase::Ensure:         return TEXT("Ensure");
+	case ERetargetPhase::RefreshNodes:   return TEXT("RefreshNodes");
+	case ERetargetPhase::Compile:        return TEXT("Compile");
+	case ERetargetPhase::GarbageCollect: return TEXT("GC");
+	case ERetargetPhase::CheckOut:       return TEXT("CheckOut");
+	case ERetargetPhase::Save:           return TEXT("Save");
+	default:                             return TEXT("Unknown");
+	}
+}
+
+
+FRetargetPhaseScope::FRetargetPhaseScope(ERetargetPhase InPhase, FName InBlueprint)
+	: Phase(InPhase)
+	, Blueprint(InBlueprint)
+	, StartTime(FPlatformTime::Seconds())
+{}
+
+FRetargetPhaseScope::FRetargetPhaseScope(ERetargetPhase InPhase, const UObject* InBlueprint)
+	: FRetargetPhaseScope(InPhase, InBlueprint ? InBlueprint->GetOutermost()->GetFName() : NAME_None)
+{}
+
+FRetargetPhaseScope::~FRetargetPhaseScope()
+{
+	// Sampled once. The process peak can't be attributed to a single phase
+	FRetargetProfiler::Get().Record(Phase, Blueprint, FPlatformTime::Seconds() - StartTime, FPlatformMemory::GetStats().UsedPhysical);
+}
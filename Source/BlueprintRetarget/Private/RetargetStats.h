@@ -0,0 +1,114 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Stats/Stats.h>
+#include <HAL/LowLevelMemTracker.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+
+class UObject;
+
+
+DECLARE_STATS_GROUP(TEXT("BlueprintRetarget"), STATGROUP_BlueprintRetarget, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Load"), STAT_BlueprintRetarget_Load, STATGROUP_BlueprintRetarget, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ensure Up To Date"), STAT_BlueprintRetarget_Ensure, STATGROUP_BlueprintRetarget, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Refresh Nodes"), STAT_BlueprintRetarget_RefreshNodes, STATGROUP_BlueprintRetarget, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compile"), STAT_BlueprintRetarget_Compile, STATGROUP_BlueprintRetarget, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Garbage Collect"), STAT_BlueprintRetarget_GarbageCollect, STATGROUP_BlueprintRetarget, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check Out"), STAT_BlueprintRetarget_CheckOut, STATGROUP_BlueprintRetarget, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Save"), STAT_BlueprintRetarget_Save, STATGROUP_BlueprintRetarget, );
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Reparented Blueprints"), STAT_BlueprintRetarget_NumReparented, STATGROUP_BlueprintRetarget, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Compiled Blueprints"), STAT_BlueprintRetarget_NumCompiled, STATGROUP_BlueprintRetarget, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Saved Blueprints"), STAT_BlueprintRetarget_NumSaved, STATGROUP_BlueprintRetarget, );
+
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("BlueprintRetarget Load"), STAT_BlueprintRetargetLLM_Load, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("BlueprintRetarget Ensure"), STAT_BlueprintRetargetLLM_Ensure, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("BlueprintRetarget RefreshNodes"), STAT_BlueprintRetargetLLM_RefreshNodes, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("BlueprintRetarget Compile"), STAT_BlueprintRetargetLLM_Compile, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("BlueprintRetarget GarbageCollect"), STAT_BlueprintRetargetLLM_GarbageCollect, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("BlueprintRetarget CheckOut"), STAT_BlueprintRetargetLLM_CheckOut, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("BlueprintRetarget Save"), STAT_BlueprintRetargetLLM_Save, STATGROUP_LLMFULL, );
+
+
+enum class ERetargetPhase : uint8
+{
+	Load,
+	Ensure,
+	RefreshNodes,
+	Compile,
+	GarbageCollect,
+	CheckOut,
+	Save,
+	Num
+};
+
+
+/** Time spent on each phase, and the highest memory used when one of them ended */
+struct FRetargetPhaseRecord
+{
+	double Seconds[(int32)ERetargetPhase::Num] = {};
+	uint64 UsedMemoryAtEnd[(int32)ERetargetPhase::Num] = {};
+
+
+	double GetTotalSeconds() const;
+};
+
+
+/**
+ * Accumulates per blueprint phase timings of a retarget, to find slow blueprints and track regressions.
+ * Work done for many blueprints at once (E.g: batch compilation) is recorded without a blueprint.
+ */
+class FRetargetProfiler
+{
+	TMap<FName, FRetargetPhaseRecord> Records;
+	FRetargetPhaseRecord Total;
+
+
+public:
+	static FRetargetProfiler& Get();
+
+	void Reset();
+
+	/** @param UsedMemoryAtEnd physical memory used by the process when the phase ended */
+	void Record(ERetargetPhase Phase, FName Blueprint, double Seconds, uint64 UsedMemoryAtEnd);
+
+	bool IsEmpty() const { return Records.Num() <= 0; }
+
+	const FRetargetPhaseRecord& GetTotal() const { return Total; }
+
+	/** Logs a table with the slowest blueprints and the totals of each phase */
+	void PrintSummary(int32 MaxRows = 20) const;
+
+	/** Writes the time and used memory at the end of each phase for every blueprint */
+	bool WriteCsv(const FString& Filename) const;
+
+	static const TCHAR* GetPhaseName(ERetargetPhase Phase);
+};
+
+
+/** Measures a phase for the profiler. Use through RETARGET_PHASE_SCOPE */
+class FRetargetPhaseScope
+{
+	ERetargetPhase Phase;
+	FName Blueprint;
+	double StartTime;
+
+public:
+	FRetargetPhaseScope(ERetargetPhase InPhase, FName InBlueprint);
+	FRetargetPhaseScope(ERetargetPhase InPhase, const UObject* InBlueprint);
+	~FRetargetPhaseScope();
+};
+
+
+/**
+ * Adds a cpu profiler trace scope, cycle stat, llm tag and profiler record for a phase.
+ * Blueprint is an object or a package name. NAME_None if the phase is not about a single blueprint.
+ */
+#define RETARGET_PHASE_SCOPE(Phase, Blueprint) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(BlueprintRetarget_##Phase); \
+	SCOPE_CYCLE_COUNTER(STAT_BlueprintRetarget_##Phase); \
+	LLM_SCOPED_TAG_WITH_STAT(STAT_BlueprintRetargetLLM_##Phase, ELLMTracker::Default); \
+	FRetargetPhaseScope RetargetPhaseScope_##Phase(ERetargetPhase::Phase, Blueprint)
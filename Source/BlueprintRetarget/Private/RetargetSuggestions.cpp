@@ -0,0 +1,266 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetSuggestions.h"
+#include "RetargetBlueprintFilter.h"
+
+#include <Async/ParallelFor.h>
+#include <UObject/UObjectIterator.h>
+#include <UObject/Package.h>
+#include <Engine/Blueprint.h>
+#include <Engine/SCS_Node.h>
+#include <Engine/SimpleConstructionScript.h>
+#include <EdGraph/EdGraph.h>
+#include <K2Node_CallFunction.h>
+#include <K2Node_Event.h>
+#include <K2Node_Variable.h>
+
+
+/** How much the name counts against the structure when both are available */
+static constexpr float NameWeight = 0.5f;
+
+
+void FParentMemberUsage::Gather(const UBlueprint* Blueprint)
+{
+	if (!Blueprint)
+	{
+		return;
+	}
+
+	TSet<FName> OwnMembers;
+	GatherOwnMembers(Blueprint, OwnMembers);
+
+	TArray<UEdGraph*> Graphs;
+	Blueprint->GetAllGraphs(Graphs);
+	for (const UEdGraph* Graph : Graphs)
+	{
+		if (!Graph)
+		{
+			continue;
+		}
+
+		for (const UEdGraphNode* Node : Graph->Nodes)
+		{
+			if (const UK2Node_Event* Event = Cast<UK2Node_Event>(Node))
+			{
+				if (Event->bOverrideFunction)
+				{
+					Events.Add(Event->EventReference.GetMemberName());
+				}
+			}
+			else if (const UK2Node_CallFunction* Call = Cast<UK2Node_CallFunction>(Node))
+			{
+				const FName Name = Call->FunctionReference.GetMemberName();
+				if (Call->FunctionReference.IsSelfContext() && !OwnMembers.Contains(Name))
+				{
+					Functions.Add(Name);
+				}
+			}
+			else if (const UK2Node_Variable* Variable = Cast<UK2Node_Variable>(Node))
+			{
+				const FName Name = Variable->VariableReference.GetMemberName();
+				if (Variable->VariableReference.IsSelfContext() && !OwnMembers.Contains(Name))
+				{
+					Variables.Add(Name);
+				}
+			}
+		}
+	}
+}
+
+void FParentMemberUsage::GatherOwnMembers(const UBlueprint* Blueprint, TSet<FName>& OutMembers)
+{
+	for (const FBPVariableDescription& Variable : Blueprint->NewVariables)
+	{
+		OutMembers.Add(Variable.VarName);
+	}
+	if (Blueprint->SimpleConstructionScript)
+	{
+		for (const USCS_Node* Node : Blueprint->SimpleConstructionScript->GetAllNodes())
+		{
+			if (Node)
+			{
+				OutMembers.Add(Node->GetVariableName());
+			}
+		}
+	}
+	for (const UEdGraph* Graph : Blueprint->FunctionGraphs)
+	{
+		if (Graph)
+		{
+			OutMembers.Add(Graph->GetFName());
+		}
+	}
+
+	// Interface functions come from the interface, not from the parent
+	for (const FBPInterfaceDescription& Interface : Blueprint->ImplementedInterfaces)
+	{
+		if (Interface.Interface)
+		{
+			for (TFieldIterator<UFunction> It(Interface.Interface); It; ++It)
+			{
+				OutMembers.Add(It->GetFName());
+			}
+		}
+	}
+}
+
+float FParentMemberUsage::Match(const UClass* Class) const
+{
+	if (!Class || Num() <= 0)
+	{
+		return 0.f;
+	}
+
+	int32 Matches = 0;
+	for (const FName& Function : Functions)
+	{
+		Matches += Class->FindFunctionByName(Function) != nullptr;
+	}
+	for (const FName& Event : Events)
+	{
+		Matches += Class->FindFunctionByName(Event) != nullptr;
+	}
+	for (const FName& Variable : Variables)
+	{
+		Matches += Class->FindPropertyByName(Variable) != nullptr;
+	}
+	return float(Matches) / Num();
+}
+
+
+FRetargetSuggestions& FRetargetSuggestions::Get()
+{
+	static FRetargetSuggestions Instance;
+	return Instance;
+}
+
+TArray<FRetargetSuggestion> FRetargetSuggestions::Suggest(const FString& MissingParentPath, const FParentMemberUsage& Usage, FRetargetBlueprintFilter* Filter, int32 MaxResults)
+{
+	if (bDirty)
+	{
+		BuildIndex();
+	}
+
+	TArray<uint64> QueryGrams;
+	GetGrams(NormalizeName(MissingParentPath), QueryGrams);
+
+	// Count trigrams shared with each class
+	TArray<int32> SharedGrams;
+	SharedGrams.SetNumZeroed(Classes.Num());
+	for (uint64 Gram : QueryGrams)
+	{
+		if (const TArray<int32>* GramClasses = ClassesByGram.Find(Gram))
+		{
+			for (int32 Index : *GramClasses)
+			{
+				++SharedGrams[Index];
+			}
+		}
+	}
+
+	// Gather candidates. The filter is not thread-safe so this happens before scoring
+	const bool bUseStructure = Usage.Num() > 0;
+	TArray<FRetargetSuggestion> Candidates;
+	TArray<const UClass*> CandidateClasses;
+	for (int32 Index = 0; Index < Classes.Num(); ++Index)
+	{
+		// Classes with no name in common can only match by structure
+		if (!bUseStructure && SharedGrams[Index] <= 0)
+		{
+			continue;
+		}
+
+		UClass* Class = Classes[Index].Class.Get();
+		if (!Class || (Filter && !Filter->IsClassEligible(Class)))
+		{
+			continue;
+		}
+
+		FRetargetSuggestion& Candidate = Candidates.AddDefaulted_GetRef();
+		Candidate.Class = Class;
+		Candidate.NameScore = (2.f * SharedGrams[Index]) / FMath::Max(1, QueryGrams.Num() + Classes[Index].NumGrams);
+		CandidateClasses.Add(Class);
+	}
+
+	ParallelFor(Candidates.Num(), [&](int32 Index) {
+		FRetargetSuggestion& Candidate = Candidates[Index];
+		if (bUseStructure)
+		{
+			Candidate.StructureScore = Usage.Match(CandidateClasses[Index]);
+			Candidate.Score = NameWeight * Candidate.NameScore + (1.f - NameWeight) * Candidate.StructureScore;
+		}
+		else
+		{
+			Candidate.Score = Candidate.NameScore;
+		}
+	});
+
+	Candidates.Sort([](const FRetargetSuggestion& A, const FRetargetSuggestion& B) {
+		return A.Score > B.Score;
+	});
+	if (Candidates.Num() > MaxResults)
+	{
+		Candidates.SetNum(MaxResults);
+	}
+	return Candidates;
+}
+
+void FRetargetSuggestions::BuildIndex()
+{
+	Classes.Reset();
+	ClassesByGram.Reset();
+
+	TArray<uint64> Grams;
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		if (Class->HasAnyClassFlags(CLASS_Deprecated | CLASS_NewerVersionExists | CLASS_Interface) || Class->GetOutermost() == GetTransientPackage())
+		{
+			continue;
+		}
+
+		// Ignore temporary classes created by blueprint compilation and reloads
+		const FString Name = Class->GetName();
+		if (Name.StartsWith(TEXT("SKEL_")) || Name.StartsWith(TEXT("REINST_")) || Name.StartsWith(TEXT("TRASHCLASS_")) || Name.StartsWith(TEXT("HOTRELOADED_")) || Name.StartsWith(TEXT("PLACEHOLDER-CLASS")))
+		{
+			continue;
+		}
+
+		GetGrams(NormalizeName(Name), Grams);
+
+		const int32 Index = Classes.AddDefaulted();
+		Classes[Index].Class = Class;
+		Classes[Index].NumGrams = Grams.Num();
+		for (uint64 Gram : Grams)
+		{
+			ClassesByGram.FindOrAdd(Gram).Add(Index);
+		}
+	}
+	bDirty = false;
+}
+
+FString FRetargetSuggestions::NormalizeName(const FString& Name)
+{
+	// Only the class name matters, not its package
+	int32 SeparatorIndex;
+	FString ClassName = Name;
+	if (ClassName.FindLastChar(TCHAR('.'), SeparatorIndex) || ClassName.FindLastChar(TCHAR('/'), SeparatorIndex))
+	{
+		ClassName = ClassName.RightChop(SeparatorIndex + 1);
+	}
+	ClassName.RemoveFromEnd(TEXT("_C"));
+	return ClassName.ToLower();
+}
+
+void FRetargetSuggestions::GetGrams(const FString& Name, TArray<uint64>& OutGrams)
+{
+	OutGrams.Reset();
+
+	// Pad so that beginnings and endings count
+	const FString Padded = TEXT("^") + Name + TEXT("$");
+	for (int32 I = 0; I + 3 <= Padded.Len(); ++I)
+	{
+		const uint64 Gram = (uint64(uint16(Padded[I])) << 32) | (uint64(uint16(Padded[I + 1])) << 16) | uint64(uint16(Padded[I + 2]));
+		OutGrams.AddUnique(Gram);
+	}
+}
@@ -0,0 +1,79 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <UObject/WeakObjectPtrTemplates.h>
+
+class UBlueprint;
+class UClass;
+class FRetargetBlueprintFilter;
+
+
+/** Members a blueprint's graphs expect to inherit from its missing parent */
+struct FParentMemberUsage
+{
+	TSet<FName> Functions;
+	TSet<FName> Events;
+	TSet<FName> Variables;
+
+
+	void Gather(const UBlueprint* Blueprint);
+
+	/** Members declared by the blueprint itself or its interfaces, which are not inherited */
+	static void GatherOwnMembers(const UBlueprint* Blueprint, TSet<FName>& OutMembers);
+
+	int32 Num() const { return Functions.Num() + Events.Num() + Variables.Num(); }
+
+	/** @return ratio [0, 1] of used members that a class provides */
+	float Match(const UClass* Class) const;
+};
+
+
+struct FRetargetSuggestion
+{
+	TWeakObjectPtr<UClass> Class;
+	float Score = 0.f;
+	float NameScore = 0.f;
+	float StructureScore = 0.f;
+};
+
+
+/**
+ * Ranks loaded classes as replacement of a missing parent.
+ * Combines a trigram index over class names with the members the blueprint uses from its parent.
+ */
+class FRetargetSuggestions
+{
+	struct FClassEntry
+	{
+		TWeakObjectPtr<UClass> Class;
+		int32 NumGrams = 0;
+	};
+
+	TArray<FClassEntry> Classes;
+	/** Trigram -> Classes containing it */
+	TMap<uint64, TArray<int32>> ClassesByGram;
+	bool bDirty = true;
+
+
+public:
+	static FRetargetSuggestions& Get();
+
+	/**
+	 * @param MissingParentPath path of the unresolved parent class (E.g: /Script/OldModule.MyActor)
+	 * @param Usage members the blueprints expect from their parent. Can be empty
+	 * @param Filter if provided, only eligible classes get suggested
+	 * @return best suggestions sorted by score
+	 */
+	TArray<FRetargetSuggestion> Suggest(const FString& MissingParentPath, const FParentMemberUsage& Usage, FRetargetBlueprintFilter* Filter, int32 MaxResults = 10);
+
+	/** Classes changed, the index will be rebuilt on next use */
+	void Invalidate() { bDirty = true; }
+
+private:
+	void BuildIndex();
+
+	static FString NormalizeName(const FString& Name);
+	static void GetGrams(const FString& Name, TArray<uint64>& OutGrams);
+};
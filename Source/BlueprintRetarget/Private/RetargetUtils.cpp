@@ -0,0 +1,149 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "RetargetUtils.h"
+
+#include <AssetData.h>
+#include <AssetRegistryModule.h>
+#include <Engine/Blueprint.h>
+#include <Misc/PackageName.h>
+#include <UObject/CoreRedirects.h>
+
+
+/** Loaded blueprints take several times their package size, counting generated classes and compilation */
+static constexpr int64 LoadedMemoryPerDiskByte = 8;
+
+
+bool FRetargetUtils::IsBlueprintAsset(const FAssetData& AssetData)
+{
+	const UClass* AssetClass = AssetData.GetClass();
+	return AssetClass && AssetClass->IsChildOf(UBlueprint::StaticClass());
+}
+
+bool FRetargetUtils::IsInvalidBlueprint(const UBlueprint* Blueprint)
+{
+	return Blueprint && (!Blueprint->SkeletonGeneratedClass || !Blueprint->GeneratedClass);
+}
+
+bool FRetargetUtils::IsInvalidBlueprint(const FAssetData& AssetData)
+{
+	if (!IsBlueprintAsset(AssetData))
+	{
+		return false;
+	}
+
+	// Already in memory, no need to guess
+	if (AssetData.IsAssetLoaded())
+	{
+		return IsInvalidBlueprint(Cast<UBlueprint>(AssetData.FastGetAsset(false)));
+	}
+
+	return !FindUnresolvedParentPath(AssetData).IsEmpty();
+}
+
+FString FRetargetUtils::FindUnresolvedParentPath(const FAssetData& AssetData)
+{
+	FString ParentClassPath;
+	if (!AssetData.GetTagValue(FBlueprintTags::ParentClassPath, ParentClassPath))
+	{
+		// Without tags we can't tell if it is broken
+		return {};
+	}
+
+	if (!IsClassPathResolved(ParentClassPath))
+	{
+		return FPackageName::ExportTextPathToObjectPath(ParentClassPath);
+	}
+
+	// A valid parent blueprint can still have lost its native base
+	FString NativeParentClassPath;
+	if (AssetData.GetTagValue(FBlueprintTags::NativeParentClassPath, NativeParentClassPath) && !IsClassPathResolved(NativeParentClassPath))
+	{
+		return FPackageName::ExportTextPathToObjectPath(NativeParentClassPath);
+	}
+	return {};
+}
+
+bool FRetargetUtils::HasMissingParent(const FAssetData& AssetData)
+{
+	FString ParentClassPath;
+	return AssetData.GetTagValue(FBlueprintTags::ParentClassPath, ParentClassPath) && !IsClassPathResolved(ParentClassPath);
+}
+
+bool FRetargetUtils::IsClassPathResolved(const FString& ExportedClassPath)
+{
+	if (ExportedClassPath.IsEmpty() || ExportedClassPath == TEXT("None"))
+	{
+		return false;
+	}
+
+	// Classes can have been renamed or moved by a redirect
+	const FCoreRedirectObjectName RedirectedName = FCoreRedirects::GetRedirectedName(ECoreRedirectFlags::Type_Class,
+		FCoreRedirectObjectName{ FPackageName::ExportTextPathToObjectPath(ExportedClassPath) });
+	const FString ClassPath = RedirectedName.ToString();
+	if (FindObject<UClass>(nullptr, *ClassPath))
+	{
+		return true;
+	}
+
+	// Native classes are always in memory if their module is loaded
+	if (FPackageName::IsScriptPackage(ClassPath))
+	{
+		return false;
+	}
+
+	// Generated class is not loaded, check if its blueprint exists
+	FString BlueprintPath = ClassPath;
+	BlueprintPath.RemoveFromEnd(TEXT("_C"));
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	return AssetRegistry.GetAssetByObjectPath(FName(*BlueprintPath)).IsValid();
+}
+
+UClass* FRetargetUtils::FindLoadedClassFromTag(const FAssetData& AssetData, FName Tag)
+{
+	FString ClassPath;
+	if (AssetData.GetTagValue(Tag, ClassPath) && ClassPath != TEXT("None"))
+	{
+		return FindObject<UClass>(nullptr, *FPackageName::ExportTextPathToObjectPath(ClassPath));
+	}
+	return nullptr;
+}
+
+FString FRetargetUtils::GetParentClassPath(const FAssetData& AssetData)
+{
+	FString ParentClassPath;
+	if (AssetData.GetTagValue(FBlueprintTags::ParentClassPath, ParentClassPath))
+	{
+		return FPackageName::ExportTextPathToObjectPath(ParentClassPath);
+	}
+	return {};
+}
+
+int64 FRetargetUtils::GetPackageDiskSize(const FAssetData& AssetData)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	const FAssetPackageData* PackageData = AssetRegistry.GetAssetPackageData(AssetData.PackageName);
+	return PackageData ? FMath::Max<int64>(PackageData->DiskSize, 0) : 0;
+}
+
+int64 FRetargetUtils::EstimateLoadedMemory(const FAssetData& AssetData)
+{
+	return GetPackageDiskSize(AssetData) * LoadedMemoryPerDiskByte;
+}
+
+TArray<TArray<int32>> FRetargetUtils::SplitByBudget(const TArray<int64>& Sizes, int64 Budget)
+{
+	TArray<TArray<int32>> Chunks;
+	int64 ChunkSize = 0;
+	for (int32 Index = 0; Index < Sizes.Num(); ++Index)
+	{
+		if (Chunks.Num() <= 0 || (Budget > 0 && ChunkSize + Sizes[Index] > Budget && Chunks.Last().Num() > 0))
+		{
+			Chunks.AddDefaulted();
+			ChunkSize = 0;
+		}
+		Chunks.Last().Add(Index);
+		ChunkSize += Sizes[Index];
+	}
+	return Chunks;
+}
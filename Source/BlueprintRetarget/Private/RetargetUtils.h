@@ -0,0 +1,62 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+struct FAssetData;
+class UBlueprint;
+class UClass;
+
+
+/** Helpers to inspect blueprints without loading them */
+struct FRetargetUtils
+{
+	/** @return true if the asset is a blueprint (or any of its subtypes) */
+	static bool IsBlueprintAsset(const FAssetData& AssetData);
+
+	/** @return true if a loaded blueprint has lost its parent class */
+	static bool IsInvalidBlueprint(const UBlueprint* Blueprint);
+
+	/**
+	 * @return true if the blueprint parent can't be resolved.
+	 * Uses only asset registry tags, never loads the asset.
+	 */
+	static bool IsInvalidBlueprint(const FAssetData& AssetData);
+
+	/**
+	 * Resolves an exported class path (E.g: Class'/Script/Engine.Actor') against loaded classes
+	 * and the asset registry, following class redirects. Native classes are only resolved if their module is loaded.
+	 */
+	static bool IsClassPathResolved(const FString& ExportedClassPath);
+
+	/**
+	 * @return true if the blueprint's own parent class can't be resolved. False if it only lost a native base further up
+	 * (E.g: its parent blueprint is the broken one). Uses only asset registry tags.
+	 */
+	static bool HasMissingParent(const FAssetData& AssetData);
+
+	/**
+	 * @return the object path of the first parent (direct or native) that can't be resolved, or empty if all are valid.
+	 * Uses only asset registry tags.
+	 */
+	static FString FindUnresolvedParentPath(const FAssetData& AssetData);
+
+	/** @return the class referenced by a tag (E.g: FBlueprintTags::ParentClassPath), only if it is loaded */
+	static UClass* FindLoadedClassFromTag(const FAssetData& AssetData, FName Tag);
+
+	/** @return the object path of the parent class as saved on the asset's tags, or empty if none */
+	static FString GetParentClassPath(const FAssetData& AssetData);
+
+	/** @return size of the asset's package on disk, or 0 if unknown */
+	static int64 GetPackageDiskSize(const FAssetData& AssetData);
+
+	/** @return rough memory a blueprint takes once loaded and compiled, estimated from its package size */
+	static int64 EstimateLoadedMemory(const FAssetData& AssetData);
+
+	/**
+	 * Splits consecutive elements in chunks whose total size fits a budget. An element bigger than the budget gets its own chunk.
+	 * @return indices of the elements of each chunk. A single chunk if the budget is 0 or less
+	 */
+	static TArray<TArray<int32>> SplitByBudget(const TArray<int64>& Sizes, int64 Budget);
+};
@@ -0,0 +1,211 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "SBrokenBlueprintsView.h"
+#include "BrokenBlueprintIndex.h"
+#include "ContentBrowserExtensions.h"
+
+#include <AssetRegistryModule.h>
+#include <ContentBrowserModule.h>
+#include <IContentBrowserSingleton.h>
+#include <EditorStyleSet.h>
+#include <Widgets/SBoxPanel.h>
+#include <Widgets/Text/STextBlock.h>
+#include <Widgets/Input/SButton.h>
+#include <Widgets/Views/SHeaderRow.h>
+#include <Widgets/Views/STableRow.h>
+
+
+#define LOCTEXT_NAMESPACE "BlueprintRetarget"
+
+static const FName ColumnBlueprint("Blueprint");
+static const FName ColumnParent("Parent");
+
+
+class SBrokenBlueprintRow : public SMultiColumnTableRow<FBrokenBlueprintItemPtr>
+{
+public:
+	SLATE_BEGIN_ARGS(SBrokenBlueprintRow) {}
+	SLATE_END_ARGS()
+
+	FBrokenBlueprintItemPtr Item;
+
+	void Construct(const FArguments& InArgs, const TSharedRef<STableViewBase>& InOwnerTable, FBrokenBlueprintItemPtr InItem)
+	{
+		Item = InItem;
+		SMultiColumnTableRow<FBrokenBlueprintItemPtr>::Construct(FSuperRowType::FArguments(), InOwnerTable);
+	}
+
+	virtual TSharedRef<SWidget> GenerateWidgetForColumn(const FName& ColumnName) override
+	{
+		const FString& Text = ColumnName == ColumnBlueprint ? Item->ObjectPath.ToString() : Item->ParentPath;
+		return SNew(STextBlock).Text(FText::FromString(Text));
+	}
+};
+
+
+SBrokenBlueprintsView::~SBrokenBlueprintsView()
+{
+	FBrokenBlueprintIndex::Get().OnChanged.RemoveAll(this);
+}
+
+void SBrokenBlueprintsView::Construct(const FArguments& InArgs)
+{
+	FBrokenBlueprintIndex::Get().OnChanged.AddSP(this, &SBrokenBlueprintsView::OnIndexChanged);
+
+	ChildSlot
+	[
+		SNew(SVerticalBox)
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(2.f)
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot()
+			.FillWidth(1.f)
+			.VAlign(VAlign_Center)
+			[
+				SNew(STextBlock)
+				.Text(this, &SBrokenBlueprintsView::GetCountText)
+			]
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(2.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(LOCTEXT("BrowseToSelected", "Browse"))
+				.ToolTipText(LOCTEXT("BrowseToSelected_Tooltip", "Shows the selected blueprints in the Content Browser"))
+				.IsEnabled(this, &SBrokenBlueprintsView::HasSelection)
+				.OnClicked(this, &SBrokenBlueprintsView::OnBrowseToSelected)
+			]
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(2.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(LOCTEXT("RetargetSelected", "Retarget invalid parent"))
+				.ToolTipText(LOCTEXT("RetargetClass_Tooltip", "Reparents a blueprint's parent class (Useful when parent class is missing or invalid)"))
+				.IsEnabled(this, &SBrokenBlueprintsView::HasSelection)
+				.OnClicked(this, &SBrokenBlueprintsView::OnRetargetSelected)
+			]
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(2.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(LOCTEXT("RestoreBackup", "Restore backups"))
+				.ToolTipText(LOCTEXT("RestoreLatestBackup_Tooltip", "Restores the blueprints of the latest bulk retarget as they were before it"))
+				.OnClicked(this, &SBrokenBlueprintsView::OnRestoreBackup)
+			]
+		]
+		+ SVerticalBox::Slot()
+		.FillHeight(1.f)
+		[
+			SAssignNew(ListView, SListView<FBrokenBlueprintItemPtr>)
+			.ListItemsSource(&Items)
+			.SelectionMode(ESelectionMode::Multi)
+			.OnGenerateRow(this, &SBrokenBlueprintsView::OnGenerateRow)
+			.OnMouseButtonDoubleClick(this, &SBrokenBlueprintsView::OnItemDoubleClicked)
+			.HeaderRow
+			(
+				SNew(SHeaderRow)
+				+ SHeaderRow::Column(ColumnBlueprint)
+				.DefaultLabel(LOCTEXT("ColumnBlueprint", "Blueprint"))
+				.FillWidth(0.6f)
+				+ SHeaderRow::Column(ColumnParent)
+				.DefaultLabel(LOCTEXT("ColumnParent", "Missing Parent"))
+				.FillWidth(0.4f)
+			)
+		]
+	];
+}
+
+void SBrokenBlueprintsView::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
+{
+	// Many changes can happen in a frame (e.g: during the initial asset scan). Refresh once
+	if (bNeedsRefresh)
+	{
+		RefreshItems();
+	}
+	SCompoundWidget::Tick(AllottedGeometry, InCurrentTime, InDeltaTime);
+}
+
+void SBrokenBlueprintsView::RefreshItems()
+{
+	bNeedsRefresh = false;
+
+	const TMap<FName, FString>& Entries = FBrokenBlueprintIndex::Get().GetEntries();
+	Items.Reset(Entries.Num());
+	for (const auto& Entry : Entries)
+	{
+		Items.Add(MakeShared<FBrokenBlueprintItem>(Entry.Key, Entry.Value));
+	}
+	Items.Sort([](const FBrokenBlueprintItemPtr& A, const FBrokenBlueprintItemPtr& B) {
+		return A->ObjectPath.Compare(B->ObjectPath) < 0;
+	});
+
+	ListView->RequestListRefresh();
+}
+
+TSharedRef<ITableRow> SBrokenBlueprintsView::OnGenerateRow(FBrokenBlueprintItemPtr Item, const TSharedRef<STableViewBase>& OwnerTable)
+{
+	return SNew(SBrokenBlueprintRow, OwnerTable, Item);
+}
+
+void SBrokenBlueprintsView::OnItemDoubleClicked(FBrokenBlueprintItemPtr Item)
+{
+	OnBrowseToSelected();
+}
+
+FText SBrokenBlueprintsView::GetCountText() const
+{
+	return FText::Format(LOCTEXT("BrokenBlueprintsCount", "{0} broken blueprints"), FText::AsNumber(Items.Num()));
+}
+
+bool SBrokenBlueprintsView::HasSelection() const
+{
+	return ListView->GetNumItemsSelected() > 0;
+}
+
+FReply SBrokenBlueprintsView::OnRetargetSelected()
+{
+	TArray<FAssetData> Assets;
+	GetSelectedAssets(Assets);
+	if (Assets.Num() > 0)
+	{
+		FBlueprintRetargetContentBrowserExtensions::RetargetAssets(Assets);
+	}
+	return FReply::Handled();
+}
+
+FReply SBrokenBlueprintsView::OnRestoreBackup()
+{
+	FBlueprintRetargetContentBrowserExtensions::RestoreBackup();
+	return FReply::Handled();
+}
+
+FReply SBrokenBlueprintsView::OnBrowseToSelected()
+{
+	TArray<FAssetData> Assets;
+	GetSelectedAssets(Assets);
+	if (Assets.Num() > 0)
+	{
+		FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>(TEXT("ContentBrowser"));
+		ContentBrowserModule.Get().SyncBrowserToAssets(Assets);
+	}
+	return FReply::Handled();
+}
+
+void SBrokenBlueprintsView::GetSelectedAssets(TArray<FAssetData>& OutAssets) const
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	for (const FBrokenBlueprintItemPtr& Item : ListView->GetSelectedItems())
+	{
+		const FAssetData AssetData = AssetRegistry.GetAssetByObjectPath(Item->ObjectPath);
+		if (AssetData.IsValid())
+		{
+			OutAssets.Add(AssetData);
+		}
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
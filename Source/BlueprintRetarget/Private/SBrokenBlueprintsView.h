@@ -0,0 +1,57 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Widgets/SCompoundWidget.h>
+#include <Widgets/Views/SListView.h>
+
+
+struct FBrokenBlueprintItem
+{
+	FName ObjectPath;
+	FString ParentPath;
+
+	FBrokenBlueprintItem(FName InObjectPath, const FString& InParentPath)
+		: ObjectPath(InObjectPath)
+		, ParentPath(InParentPath)
+	{}
+};
+
+using FBrokenBlueprintItemPtr = TSharedPtr<FBrokenBlueprintItem>;
+
+
+/** Lists every blueprint of the project with a missing parent */
+class SBrokenBlueprintsView : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SBrokenBlueprintsView) {}
+	SLATE_END_ARGS()
+
+	~SBrokenBlueprintsView();
+
+	void Construct(const FArguments& InArgs);
+
+	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
+
+private:
+
+	TArray<FBrokenBlueprintItemPtr> Items;
+	TSharedPtr<SListView<FBrokenBlueprintItemPtr>> ListView;
+	bool bNeedsRefresh = true;
+
+
+	void RefreshItems();
+	void OnIndexChanged() { bNeedsRefresh = true; }
+
+	TSharedRef<ITableRow> OnGenerateRow(FBrokenBlueprintItemPtr Item, const TSharedRef<STableViewBase>& OwnerTable);
+	void OnItemDoubleClicked(FBrokenBlueprintItemPtr Item);
+
+	FText GetCountText() const;
+	bool HasSelection() const;
+	FReply OnRetargetSelected();
+	FReply OnBrowseToSelected();
+	FReply OnRestoreBackup();
+
+	void GetSelectedAssets(TArray<struct FAssetData>& OutAssets) const;
+};
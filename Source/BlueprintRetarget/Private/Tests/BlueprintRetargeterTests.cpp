@@ -0,0 +1,81 @@
+// Copyright 2015-2020 Piperift. All Rights Reserved.
+
+#include "BlueprintRetargeter.h"
+
+#include <Engine/Blueprint.h>
+#include <Engine/BlueprintGeneratedClass.h>
+#include <EdGraph/EdGraph.h>
+#include <EdGraphSchema_K2.h>
+#include <GameFramework/Actor.h>
+#include <K2Node_CallFunction.h>
+#include <Kismet2/BlueprintEditorUtils.h>
+#include <Kismet2/KismetEditorUtilities.h>
+#include <Misc/AutomationTest.h>
+#include <UObject/Package.h>
+#include <UObject/UObjectHash.h>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static UBlueprint* CreateTestBlueprint(UClass* ParentClass, const FString& Name)
+{
+	UPackage* Package = CreatePackage(nullptr, *(TEXT("/Temp/BlueprintRetargetTests/") + Name));
+	Package->SetFlags(RF_Transient);
+	return FKismetEditorUtilities::CreateBlueprint(ParentClass, Package, FName(*Name), BPTYPE_Normal, UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass());
+}
+
+static void DestroyTestBlueprints(const TArray<UBlueprint*>& Blueprints)
+{
+	for (UBlueprint* Blueprint : Blueprints)
+	{
+		ForEachObjectWithOuter(Blueprint->GetOutermost(), [](UObject* Object) {
+			Object->ClearFlags(RF_Standalone | RF_Public);
+		}, true);
+	}
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBlueprintRetargetInheritedCallTest, "BlueprintRetarget.Reparent.InheritedFunctionCall",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FBlueprintRetargetInheritedCallTest::RunTest(const FString& Parameters)
+{
+	// The call targets a function the old parent doesn't have, but the new one inherits from Actor
+	UBlueprint* OldParent = CreateTestBlueprint(UObject::StaticClass(), TEXT("BP_RetargetTest_OldParent"));
+	UBlueprint* Blueprint = CreateTestBlueprint(OldParent->GeneratedClass, TEXT("BP_RetargetTest_Child"));
+
+	UEdGraph* Graph = FBlueprintEditorUtils::FindEventGraph(Blueprint);
+	FGraphNodeCreator<UK2Node_CallFunction> CallCreator(*Graph);
+	UK2Node_CallFunction* Call = CallCreator.CreateNode();
+	Call->FunctionReference.SetSelfMember(GET_FUNCTION_NAME_CHECKED(AActor, K2_GetActorLocation));
+	CallCreator.Finalize();
+
+	// Like after loading it without its parent. The skeleton class still derives from the old one
+	Blueprint->ParentClass = nullptr;
+	Blueprint->Status = BS_Error;
+
+	FBlueprintRetargeter Retargeter{ false };
+	if (!TestTrue(TEXT("Blueprint was reparented"), Retargeter.BeginReparent(Blueprint, AActor::StaticClass())))
+	{
+		DestroyTestBlueprints({ Blueprint, OldParent });
+		return false;
+	}
+
+	TestNotNull(TEXT("Inherited function is resolved"), Call->GetTargetFunction());
+	const UEdGraphPin* ReturnPin = Call->FindPin(UEdGraphSchema_K2::PN_ReturnValue);
+	TestTrue(TEXT("Return value pin exists"), ReturnPin && !ReturnPin->bOrphanedPin);
+	for (const UEdGraphPin* Pin : Call->Pins)
+	{
+		TestFalse(FString::Printf(TEXT("Pin %s is not orphaned"), *Pin->PinName.ToString()), Pin->bOrphanedPin);
+	}
+
+	Retargeter.CompileBlueprints({ Blueprint });
+	Retargeter.EndReparent(Blueprint);
+	TestNotEqual(TEXT("Blueprint compiles"), Blueprint->Status, BS_Error);
+
+	DestroyTestBlueprints({ Blueprint, OldParent });
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
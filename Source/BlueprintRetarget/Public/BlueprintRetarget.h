@@ -10,6 +10,8 @@ DECLARE_LOG_CATEGORY_EXTERN(LogBlueprintReparent, All, All);
 
 class FToolBarBuilder;
 class FMenuBuilder;
+class FSpawnTabArgs;
+class SDockTab;
 
 class FBlueprintRetargetModule : public IModuleInterface
 {
@@ -18,4 +20,11 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+
+	FDelegateHandle ModulesChangedHandle;
+
+
+	TSharedRef<SDockTab> SpawnBrokenBlueprintsTab(const FSpawnTabArgs& Args);
 };